@@ -0,0 +1,67 @@
+# Copyright 2021 Torsten Mehnert
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#      http://www.apache.org/licenses/LICENSE-2.0
+#
+#  Unless required by applicable law or agreed to in writing, software
+#  distributed under the License is distributed on an "AS IS" BASIS,
+#  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+#  See the License for the specific language governing permissions and
+#  limitations under the License.
+import importlib.util
+import pytest
+import sys
+
+from os.path import dirname
+
+sys.path.insert(0, "%s/../test" % dirname(__file__))
+
+from fixtures.timespan import Timespan  # noqa: E402
+from fixtures.todo import TodoWithSlots  # noqa: E402
+
+
+def load_test_fixtures():
+    """The conftest of the tests, which can't be imported by its name."""
+    spec = importlib.util.spec_from_file_location("test_conftest", "%s/../test/conftest.py" % dirname(__file__))
+    module = importlib.util.module_from_spec(spec)
+    spec.loader.exec_module(module)
+    return module
+
+
+# Benchmarks render the same views, bindings and prototypes as the tests.
+test_fixtures = load_test_fixtures()
+views = test_fixtures.views
+views_path = test_fixtures.views_path
+bindings = test_fixtures.bindings
+prototypes = test_fixtures.prototypes
+quickjs_renderer = test_fixtures.quickjs_renderer
+
+
+@pytest.fixture
+def todolist():
+    def create(count):
+        return {"todos": [
+            TodoWithSlots(what="Todo number %d" % i,
+                          description="Description of todo number %d" % i,
+                          updateLink="https://example.org/todos/%d" % i,
+                          timespan=Timespan(amount=i, unit="days", veryLate=i % 2 == 0))
+            for i in range(count)
+        ]}
+
+    return create
+
+
+@pytest.fixture
+def rows():
+    return [{
+        "id": i,
+        "what": "Todo number %d" % i,
+        "description": "Description of todo number %d" % i,
+        "done": i % 2 == 0,
+        "progress": i / 1000,
+        "tags": ["tag-a", "tag-b", "tag-c"],
+        "timespan": {"amount": i, "unit": "days", "veryLate": i % 3 == 0}
+    } for i in range(5000)]
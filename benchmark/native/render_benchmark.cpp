@@ -0,0 +1,201 @@
+/**
+ * Copyright 2021 Torsten Mehnert
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+#include <benchmark/benchmark.h>
+#include <complate/core/stringstream.h>
+#include <complate/quickjs/quickjsrendererbuilder.h>
+
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <string>
+
+using namespace std;
+using namespace complate;
+
+namespace {
+const char *const CALLBACK_VIEWS = R"JS(
+function render(view, parameters, stream) {
+    var total = 0;
+    for (var i = 0; i < parameters.count; i++) {
+        total += callback(i);
+    }
+    stream.write(String(total));
+}
+)JS";
+
+const char *const PROTOTYPE_VIEWS = R"JS(
+function render(view, parameters, stream) {
+    var total = 0;
+    for (var i = 0; i < parameters.count; i++) {
+        total += parameters.todo.amount;
+    }
+    stream.write(String(total));
+}
+)JS";
+
+/** Stream which drops the output, to measure the renderer only. */
+class NullStream : public Stream {
+public:
+  void write(const char *, int) override {}
+  void writeln(const char *, int) override {}
+  void flush() override {}
+};
+
+struct Timespan {
+  int32_t amount;
+};
+
+string views() {
+  ifstream file(VIEWS_JS);
+  stringstream content;
+  content << file.rdbuf();
+  return content.str();
+}
+
+Object bindings() {
+  auto link = [](const Array &args) {
+    return Value("https://cdn.jsdelivr.net/npm/bootstrap@5.1.0/dist/" +
+                 args.at(0).exactly<String>().get<string>());
+  };
+  return Object{
+      {"renderedBy", Value(string("complate-cpp-for-python"))},
+      {"getRendererLink", Value(Function([](const Array &) {
+         return Value(
+             string("https://github.com/tmehnert/complate-cpp-for-python"));
+       }))},
+      {"assets", Value(Object{{"link", Value(Function(link))}})}};
+}
+
+Object todolist(int64_t count) {
+  Array todos;
+  for (int64_t i = 0; i < count; ++i) {
+    todos.emplace_back(Object{
+        {"what", Value("Todo number " + to_string(i))},
+        {"description", Value("Description of todo number " + to_string(i))},
+        {"updateLink", Value("https://example.org/todos/" + to_string(i))},
+        {"timespan",
+         Value(Object{{"amount", Value(static_cast<int32_t>(i))},
+                      {"unit", Value(string("days"))},
+                      {"veryLate", Value(i % 2 == 0)}})}});
+  }
+  return Object{{"todos", Value(move(todos))}};
+}
+
+string todolistJson(int64_t count) {
+  stringstream json;
+  json << R"({"todos":[)";
+  for (int64_t i = 0; i < count; ++i) {
+    json << (i ? "," : "") << R"({"what":"Todo number )" << i
+         << R"(","description":"Description of todo number )" << i
+         << R"(","updateLink":"https://example.org/todos/)" << i
+         << R"(","timespan":{"amount":)" << i
+         << R"(,"unit":"days","veryLate":)" << (i % 2 == 0 ? "true" : "false")
+         << "}}";
+  }
+  json << "]}";
+  return json.str();
+}
+
+unique_ptr<Renderer> renderer() {
+  return QuickJsRendererBuilder().source(views()).bindings(bindings()).unique();
+}
+}  // namespace
+
+static void BM_Construct(benchmark::State &state) {
+  auto source = views();
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        QuickJsRendererBuilder().source(source).bindings(bindings()).unique());
+  }
+}
+BENCHMARK(BM_Construct)->Unit(benchmark::kMillisecond);
+
+static void BM_RenderObject(benchmark::State &state) {
+  auto quickjs = renderer();
+  auto parameters = todolist(state.range(0));
+  NullStream stream;
+  for (auto _ : state) {
+    quickjs->render("TodoList", parameters, stream);
+  }
+}
+BENCHMARK(BM_RenderObject)->Arg(2)->Arg(1000)->Unit(benchmark::kMicrosecond);
+
+static void BM_RenderJson(benchmark::State &state) {
+  auto quickjs = renderer();
+  auto parameters = todolistJson(state.range(0));
+  NullStream stream;
+  for (auto _ : state) {
+    quickjs->render("TodoList", parameters, stream);
+  }
+}
+BENCHMARK(BM_RenderJson)->Arg(2)->Arg(1000)->Unit(benchmark::kMicrosecond);
+
+static void BM_RenderStringStream(benchmark::State &state) {
+  auto quickjs = renderer();
+  auto parameters = todolist(state.range(0));
+  for (auto _ : state) {
+    StringStream stream;
+    quickjs->render("TodoList", parameters, stream);
+    benchmark::DoNotOptimize(stream.str());
+  }
+}
+BENCHMARK(BM_RenderStringStream)
+    ->Arg(2)
+    ->Arg(1000)
+    ->Unit(benchmark::kMicrosecond);
+
+static void BM_BindingCalls(benchmark::State &state) {
+  auto quickjs =
+      QuickJsRendererBuilder()
+          .source(CALLBACK_VIEWS)
+          .bindings(Object{{"callback", Value(Function([](const Array &) {
+                              return Value(static_cast<int32_t>(1));
+                            }))}})
+          .unique();
+  Object parameters{{"count", Value(static_cast<int32_t>(state.range(0)))}};
+  NullStream stream;
+  for (auto _ : state) {
+    quickjs->render("Callbacks", parameters, stream);
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_BindingCalls)->Arg(10000)->Unit(benchmark::kMicrosecond);
+
+static void BM_PrototypeAccess(benchmark::State &state) {
+  Prototype prototype("Timespan");
+  prototype.addProperty(Property(
+      "amount",
+      [](void *p) { return Value(static_cast<Timespan *>(p)->amount); },
+      [](void *p, const Value &value) {
+        static_cast<Timespan *>(p)->amount =
+            value.exactly<Number>().exactly<int32_t>();
+      }));
+  auto quickjs = QuickJsRendererBuilder()
+                     .source(PROTOTYPE_VIEWS)
+                     .prototypes({prototype})
+                     .unique();
+  auto timespan = make_shared<Timespan>(Timespan{1});
+  Object parameters{{"todo", Value(Proxy("Timespan", timespan))},
+                    {"count", Value(static_cast<int32_t>(state.range(0)))}};
+  NullStream stream;
+  for (auto _ : state) {
+    quickjs->render("Prototypes", parameters, stream);
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_PrototypeAccess)->Arg(10000)->Unit(benchmark::kMicrosecond);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,38 @@
+# Copyright 2021 Torsten Mehnert
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#      http://www.apache.org/licenses/LICENSE-2.0
+#
+#  Unless required by applicable law or agreed to in writing, software
+#  distributed under the License is distributed on an "AS IS" BASIS,
+#  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+#  See the License for the specific language governing permissions and
+#  limitations under the License.
+from complatecpp import QuickJsRenderer, QuickJsRendererBuilder
+
+VIEWS = """
+function render(view, parameters, stream) {
+    stream.write(`<li>${parameters.what}</li>`)
+}
+"""
+
+
+def test_render_loop(benchmark, rows):
+    renderer = QuickJsRenderer(VIEWS)
+    items = [("Row", row) for row in rows]
+    benchmark(lambda: [renderer.render_tostring(view, parameters) for view, parameters in items])
+
+
+def test_render_batch(benchmark, rows):
+    renderer = QuickJsRenderer(VIEWS)
+    items = [("Row", row) for row in rows]
+    benchmark(lambda: renderer.render_batch(items))
+
+
+def test_render_batch_pool(benchmark, rows):
+    renderer = QuickJsRendererBuilder().source(VIEWS).pool(4)
+    items = [("Row", row) for row in rows]
+    benchmark(lambda: renderer.render_batch(items))
@@ -0,0 +1,32 @@
+# Copyright 2021 Torsten Mehnert
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#      http://www.apache.org/licenses/LICENSE-2.0
+#
+#  Unless required by applicable law or agreed to in writing, software
+#  distributed under the License is distributed on an "AS IS" BASIS,
+#  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+#  See the License for the specific language governing permissions and
+#  limitations under the License.
+from complatecpp import QuickJsRendererBuilder
+
+VIEWS = """
+function render(view, parameters, stream) {
+    var total = 0;
+    for (var i = 0; i < parameters.count; i++) {
+        total += callback(i, [i, i + 1], {index: i, label: "row"});
+    }
+    stream.write(String(total));
+}
+"""
+
+
+def test_callback_heavy_view(benchmark):
+    renderer = QuickJsRendererBuilder() \
+        .source(VIEWS) \
+        .bindings({"callback": lambda index, pair, row: pair[1] - row["index"]}) \
+        .unique()
+    assert benchmark(lambda: renderer.render_tostring("Callbacks", {"count": 10000})) == "10000"
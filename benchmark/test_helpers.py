@@ -0,0 +1,86 @@
+# Copyright 2021 Torsten Mehnert
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#      http://www.apache.org/licenses/LICENSE-2.0
+#
+#  Unless required by applicable law or agreed to in writing, software
+#  distributed under the License is distributed on an "AS IS" BASIS,
+#  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+#  See the License for the specific language governing permissions and
+#  limitations under the License.
+import pytest
+
+from complatecpp import QuickJsRendererBuilder
+
+# htmlEncode() as shipped with complate, which views use without native helpers.
+VIEWS = """
+var HTML_ENTITIES = {
+    "&": "&amp;",
+    "<": "&lt;",
+    ">": "&gt;",
+    "\\"": "&quot;",
+    "'": "&#x27;"
+};
+
+function htmlEncode(str, attribute) {
+    var pattern = attribute ? /[&<>'"]/g : /[&<>]/g;
+    var match = pattern.exec(str);
+    if (!match) {
+        return str;
+    }
+    var res = "";
+    var last = 0;
+    do {
+        var index = match.index;
+        if (last !== index) {
+            res += str.substring(last, index);
+        }
+        res += HTML_ENTITIES[match[0]];
+        last = pattern.lastIndex;
+    } while ((match = pattern.exec(str)));
+    if (last !== str.length) {
+        res += str.substring(last);
+    }
+    return res;
+}
+
+function render(view, parameters, stream) {
+    var escape = view === "Native" ? complatecpp.escapeHtml : htmlEncode;
+    var rows = parameters.rows;
+    stream.write("<table>");
+    for (var i = 0; i < rows.length; i++) {
+        var row = rows[i];
+        stream.write("<tr title=\\"" + escape(row.title, true) + "\\"><td>" + escape(row.what) + "</td><td>" +
+                     escape(row.description) + "</td></tr>");
+    }
+    stream.write("</table>");
+}
+"""
+
+
+@pytest.fixture
+def table_rows():
+    return [{
+        "title": "Todo \"%d\" isn't done" % i,
+        "what": "Todo <number> %d" % i,
+        "description": "Description of todo & number %d, which needs <b>escaping</b>" % i
+    } for i in range(10000)]
+
+
+@pytest.fixture
+def renderer():
+    return QuickJsRendererBuilder().source(VIEWS).native_helpers().unique()
+
+
+def test_escape_stock(benchmark, renderer, table_rows):
+    parameters = {"rows": table_rows}
+    benchmark(lambda: renderer.render_tostring("Stock", parameters))
+
+
+def test_escape_native(benchmark, renderer, table_rows):
+    parameters = {"rows": table_rows}
+    html = benchmark(lambda: renderer.render_tostring("Native", parameters))
+    assert html == renderer.render_tostring("Stock", parameters)
@@ -0,0 +1,107 @@
+# Copyright 2021 Torsten Mehnert
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#      http://www.apache.org/licenses/LICENSE-2.0
+#
+#  Unless required by applicable law or agreed to in writing, software
+#  distributed under the License is distributed on an "AS IS" BASIS,
+#  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+#  See the License for the specific language governing permissions and
+#  limitations under the License.
+import json
+import os
+import pytest
+import resource
+import tracemalloc
+
+from complatecpp import Value, QuickJsRenderer, dumps_params
+
+VIEWS = """
+function render(view, parameters, stream) {
+    stream.write(String(parameters.rows.length))
+}
+"""
+
+
+def test_value_from_dict(benchmark, rows):
+    parameters = {"rows": rows}
+    benchmark(lambda: Value(parameters))
+
+
+def test_render_with_dict(benchmark, rows):
+    renderer = QuickJsRenderer(VIEWS)
+    parameters = {"rows": rows}
+    assert benchmark(lambda: renderer.render_tostring("Rows", parameters)) == "5000"
+
+
+def test_render_with_json_dumps(benchmark, rows):
+    renderer = QuickJsRenderer(VIEWS)
+    parameters = {"rows": rows}
+    assert benchmark(lambda: renderer.render_tostring("Rows", json.dumps(parameters))) == "5000"
+
+
+def test_dumps_params(benchmark, rows):
+    parameters = {"rows": rows}
+    benchmark(lambda: dumps_params(parameters))
+
+
+def test_json_dumps(benchmark, rows):
+    parameters = {"rows": rows}
+    benchmark(lambda: json.dumps(parameters))
+
+
+def test_render_with_dumps_params(benchmark, rows):
+    renderer = QuickJsRenderer(VIEWS)
+    parameters = {"rows": rows}
+    assert benchmark(lambda: renderer.render_tostring("Rows", dumps_params(parameters))) == "5000"
+
+
+def test_render_with_dict_as_json(benchmark, rows):
+    renderer = QuickJsRenderer(VIEWS)
+    parameters = {"rows": rows}
+    assert benchmark(lambda: renderer.render_tostring("Rows", parameters, as_json=True)) == "5000"
+
+
+def traced_peak(render):
+    """Peak of memory allocated through Python during a render, in bytes."""
+    tracemalloc.start()
+    try:
+        render()
+        return tracemalloc.get_traced_memory()[1]
+    finally:
+        tracemalloc.stop()
+
+
+def test_render_with_dict_as_json_allocations(benchmark, rows):
+    renderer = QuickJsRenderer(VIEWS)
+    parameters = {"rows": rows}
+    renderer.render_tostring("Rows", parameters, as_json=True)
+    as_json = traced_peak(lambda: renderer.render_tostring("Rows", parameters, as_json=True))
+    as_dict = traced_peak(lambda: renderer.render_tostring("Rows", parameters))
+    benchmark.extra_info["traced_peak_as_json"] = as_json
+    benchmark.extra_info["traced_peak_as_dict"] = as_dict
+    benchmark(lambda: renderer.render_tostring("Rows", parameters, as_json=True))
+    assert as_json <= as_dict
+
+
+def current_rss():
+    """Resident set size of the process right now, in bytes."""
+    with open("/proc/self/statm") as statm:
+        return int(statm.read().split()[1]) * resource.getpagesize()
+
+
+@pytest.mark.skipif(not os.path.exists("/proc/self/statm"), reason="requires /proc")
+def test_render_with_dict_as_json_soak(rows):
+    renderer = QuickJsRenderer(VIEWS)
+    parameters = {"rows": rows}
+    for _ in range(50):
+        renderer.render_tostring("Rows", parameters, as_json=True)
+    before = current_rss()
+    for _ in range(500):
+        renderer.render_tostring("Rows", parameters, as_json=True)
+    after = current_rss()
+    # The peak hides memory, which is released and allocated again
+    assert after - before < 16 * 1024 * 1024
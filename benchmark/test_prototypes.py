@@ -0,0 +1,44 @@
+# Copyright 2021 Torsten Mehnert
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#      http://www.apache.org/licenses/LICENSE-2.0
+#
+#  Unless required by applicable law or agreed to in writing, software
+#  distributed under the License is distributed on an "AS IS" BASIS,
+#  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+#  See the License for the specific language governing permissions and
+#  limitations under the License.
+from complatecpp import QuickJsRendererBuilder
+
+from fixtures.timespan import Timespan
+from fixtures.todo import TodoWithProps
+
+VIEWS = """
+function render(view, parameters, stream) {
+    var total = 0;
+    for (var i = 0; i < parameters.rounds; i++) {
+        parameters.items.forEach(function (item) {
+            total += item.amount + (item.veryLate ? 1 : 0) + item.unit.length;
+        });
+    }
+    stream.write(String(total));
+}
+"""
+
+
+def test_slots_property_access(benchmark):
+    renderer = QuickJsRendererBuilder().source(VIEWS).prototypes([Timespan]).unique()
+    items = [Timespan(amount=i, unit="days", veryLate=i % 2 == 0) for i in range(100)]
+    benchmark(lambda: renderer.render_tostring("Timespans", {"items": items, "rounds": 100}))
+
+
+def test_props_property_access(benchmark):
+    renderer = QuickJsRendererBuilder().source(VIEWS.replace("item.", "item.timespan.")) \
+        .prototypes([TodoWithProps, Timespan]) \
+        .unique()
+    items = [TodoWithProps(what="", description="", updateLink="",
+                           timespan=Timespan(amount=i, unit="days", veryLate=i % 2 == 0)) for i in range(100)]
+    benchmark(lambda: renderer.render_tostring("Todos", {"items": items, "rounds": 100}))
@@ -0,0 +1,64 @@
+# Copyright 2021 Torsten Mehnert
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#      http://www.apache.org/licenses/LICENSE-2.0
+#
+#  Unless required by applicable law or agreed to in writing, software
+#  distributed under the License is distributed on an "AS IS" BASIS,
+#  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+#  See the License for the specific language governing permissions and
+#  limitations under the License.
+import json
+import pytest
+
+from complatecpp import BufferedStream, Stream, StringStream
+from fixtures.encoder import Encoder
+
+
+class NullStream(Stream):
+    def write(self, string, length):
+        pass
+
+    def writeln(self, string, length):
+        pass
+
+    def flush(self):
+        pass
+
+
+class NullTarget:
+    def write(self, chunk):
+        pass
+
+    def flush(self):
+        pass
+
+
+@pytest.mark.parametrize("count", [2, 1000])
+def test_render_todolist_dict(benchmark, todolist, quickjs_renderer, count):
+    parameters = todolist(count)
+    benchmark(lambda: quickjs_renderer.render_tostring("TodoList", parameters))
+
+
+@pytest.mark.parametrize("count", [2, 1000])
+def test_render_todolist_json(benchmark, todolist, quickjs_renderer, count):
+    parameters = json.dumps(todolist(count), cls=Encoder)
+    benchmark(lambda: quickjs_renderer.render_tostring("TodoList", parameters))
+
+
+def test_render_to_stringstream(benchmark, todolist, quickjs_renderer):
+    parameters = todolist(1000)
+    benchmark(lambda: quickjs_renderer.render("TodoList", parameters, StringStream()))
+
+
+def test_render_to_python_stream(benchmark, todolist, quickjs_renderer):
+    parameters = todolist(1000)
+    benchmark(lambda: quickjs_renderer.render("TodoList", parameters, NullStream()))
+
+
+def test_render_to_bufferedstream(benchmark, todolist, quickjs_renderer):
+    parameters = todolist(1000)
+    benchmark(lambda: quickjs_renderer.render("TodoList", parameters, BufferedStream(NullTarget())))
@@ -0,0 +1,69 @@
+# Copyright 2021 Torsten Mehnert
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#      http://www.apache.org/licenses/LICENSE-2.0
+#
+#  Unless required by applicable law or agreed to in writing, software
+#  distributed under the License is distributed on an "AS IS" BASIS,
+#  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+#  See the License for the specific language governing permissions and
+#  limitations under the License.
+import pytest
+from complatecpp import QuickJsRendererBuilder, runtime_hook
+
+
+def test_unique_from_source(benchmark, views):
+    benchmark(lambda: QuickJsRendererBuilder().source(views).unique())
+
+
+def test_unique_from_source_creator(benchmark, views_path):
+    def read():
+        with open(views_path) as views:
+            return views.read()
+
+    benchmark(lambda: QuickJsRendererBuilder().source(read).unique())
+
+
+def test_unique_from_source_file(benchmark, views_path):
+    benchmark(lambda: QuickJsRendererBuilder().source_file(views_path).unique())
+
+
+def test_pool_from_source_creator(benchmark, views_path):
+    def read():
+        with open(views_path) as views:
+            return views.read()
+
+    benchmark(lambda: QuickJsRendererBuilder().source(read).pool(4))
+
+
+def test_pool_from_source_file(benchmark, views_path):
+    benchmark(lambda: QuickJsRendererBuilder().source_file(views_path).pool(4))
+
+
+requires_runtime_hook = pytest.mark.skipif(not runtime_hook, reason="requires the runtime hook")
+
+
+@requires_runtime_hook
+def test_unique_from_bytecode_cache(benchmark, views):
+    builder = QuickJsRendererBuilder().source(views).bytecode_cache()
+    builder.unique()
+    benchmark(builder.unique)
+
+
+@requires_runtime_hook
+def test_unique_from_bytecode_cache_directory(benchmark, views, tmp_path):
+    QuickJsRendererBuilder().source(views).bytecode_cache(str(tmp_path)).unique()
+    benchmark(lambda: QuickJsRendererBuilder().source(views).bytecode_cache(str(tmp_path)).unique())
+
+
+def test_pool_from_source(benchmark, views):
+    benchmark(lambda: QuickJsRendererBuilder().source(views).pool(4))
+
+
+@requires_runtime_hook
+def test_pool_from_bytecode_cache_directory(benchmark, views, tmp_path):
+    QuickJsRendererBuilder().source(views).bytecode_cache(str(tmp_path)).unique()
+    benchmark(lambda: QuickJsRendererBuilder().source(views).bytecode_cache(str(tmp_path)).pool(4))
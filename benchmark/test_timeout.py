@@ -0,0 +1,37 @@
+# Copyright 2021 Torsten Mehnert
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#      http://www.apache.org/licenses/LICENSE-2.0
+#
+#  Unless required by applicable law or agreed to in writing, software
+#  distributed under the License is distributed on an "AS IS" BASIS,
+#  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+#  See the License for the specific language governing permissions and
+#  limitations under the License.
+import json
+import pytest
+
+from complatecpp import QuickJsRendererBuilder
+from fixtures.encoder import Encoder
+
+
+@pytest.mark.parametrize("timeout_ms", [0, 60000])
+def test_render_todolist_dict(benchmark, todolist, quickjs_renderer, timeout_ms):
+    parameters = todolist(1000)
+    benchmark(lambda: quickjs_renderer.render_tostring("TodoList", parameters, timeout_ms=timeout_ms))
+
+
+@pytest.mark.parametrize("timeout_ms", [0, 60000])
+def test_render_todolist_json(benchmark, todolist, quickjs_renderer, timeout_ms):
+    parameters = json.dumps(todolist(1000), cls=Encoder)
+    benchmark(lambda: quickjs_renderer.render_tostring("TodoList", parameters, timeout_ms=timeout_ms))
+
+
+@pytest.mark.parametrize("timeout_ms", [0, 60000])
+def test_render_todolist_pool(benchmark, todolist, views, bindings, prototypes, timeout_ms):
+    pool = QuickJsRendererBuilder().source(views).bindings(bindings).prototypes(prototypes).pool(1)
+    parameters = json.dumps(todolist(1000), cls=Encoder)
+    benchmark(lambda: pool.render_tostring("TodoList", parameters, timeout_ms=timeout_ms))
@@ -26,5 +26,8 @@ setup(
     package_dir={"": "src"},
     cmake_install_dir="src/complatecpp",
     include_package_data=True,
-    extras_require={"test": ["pytest"]},
+    extras_require={
+        "test": ["pytest"],
+        "benchmark": ["pytest", "pytest-benchmark"],
+    },
 )
@@ -11,5 +11,24 @@
 #  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
 #  See the License for the specific language governing permissions and
 #  limitations under the License.
-from .core import Value, Function, Stream, StringStream, Renderer
-from .quickjs import QuickJsRenderer, QuickJsRendererBuilder
\ No newline at end of file
+import os
+
+from .core import Value, Function, Stream, StringStream, BufferedStream, Renderer, CachingRenderer, \
+    SegmentRenderer, SegmentedPage, dumps_params
+from .quickjs import QuickJsRenderer, QuickJsRendererBuilder, QuickJsRendererPool, InstrumentedRenderer, \
+    prepare_fork, after_fork_in_parent, after_fork_in_child, runtime_hook
+
+_registered_at_fork = False
+
+
+def register_at_fork():
+    """Pause renderer pools while the process forks, with os.register_at_fork().
+
+    Call it once in applications forked by servers like gunicorn. Further calls
+    have no effect.
+    """
+    global _registered_at_fork
+    if not _registered_at_fork:
+        os.register_at_fork(before=prepare_fork, after_in_parent=after_fork_in_parent,
+                            after_in_child=after_fork_in_child)
+        _registered_at_fork = True
@@ -0,0 +1,146 @@
+/**
+ * Copyright 2021 Torsten Mehnert
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+#pragma once
+
+#include <complate/core/stream.h>
+#include <pybind11/pybind11.h>
+
+#include <string>
+
+class BufferedStream : public complate::Stream {
+public:
+  BufferedStream(pybind11::object target, std::size_t threshold)
+      : m_target(std::move(target)),
+        m_stream(pybind11::isinstance<complate::Stream>(m_target)
+                     ? m_target.cast<complate::Stream *>()
+                     : nullptr),
+        m_threshold(threshold) {
+    m_buffer.reserve(threshold);
+  }
+
+  /** Forward what is left, output isn't lost when nobody flushed. */
+  ~BufferedStream() override {
+    try {
+      flush();
+    } catch (...) {
+    }
+  }
+
+  BufferedStream(const BufferedStream &) = delete;
+  BufferedStream &operator=(const BufferedStream &) = delete;
+
+  void write(const char *str, int len) override {
+    m_buffer.append(str, len);
+    if (m_buffer.size() >= m_threshold) {
+      forward(complete());
+    }
+  }
+
+  void writeln(const char *str, int len) override {
+    m_buffer.append(str, len);
+    m_buffer.push_back('\n');
+    if (m_buffer.size() >= m_threshold) {
+      forward(complete());
+    }
+  }
+
+  void flush() override {
+    forward(m_buffer.size());
+    if (m_stream) {
+      m_stream->flush();
+    } else {
+      pybind11::gil_scoped_acquire acquire;
+      if (pybind11::hasattr(m_target, "flush")) {
+        m_target.attr("flush")();
+      }
+    }
+  }
+
+  [[nodiscard]] std::size_t buffered() const { return m_buffer.size(); }
+
+private:
+  /**
+   * Length of the buffer without a trailing, incomplete UTF-8 sequence.
+   *
+   * Python streams receive every chunk as str, so a chunk must not end in
+   * the middle of a character. The rest is forwarded with the next chunk.
+   */
+  [[nodiscard]] std::size_t complete() const {
+    auto size = m_buffer.size();
+    std::size_t start = size;
+    while (start > 0 && size - start < 4 &&
+           (static_cast<unsigned char>(m_buffer[start - 1]) & 0xC0) == 0x80) {
+      --start;
+    }
+    if (start == 0) {
+      return size;
+    }
+    auto lead = static_cast<unsigned char>(m_buffer[start - 1]);
+    std::size_t length = lead < 0x80   ? 1
+                         : lead < 0xE0 ? 2
+                         : lead < 0xF0 ? 3
+                                       : 4;
+    return size - start + 1 < length ? start - 1 : size;
+  }
+
+  void forward(std::size_t length) {
+    if (length == 0) {
+      return;
+    }
+    if (m_stream) {
+      /* Streams implemented in Python read the chunk up to its end. */
+      auto chunk = length < m_buffer.size() ? m_buffer.substr(0, length)
+                                            : std::string();
+      const auto &data = chunk.empty() ? m_buffer : chunk;
+      m_stream->write(data.c_str(), static_cast<int>(length));
+    } else {
+      pybind11::gil_scoped_acquire acquire;
+      pybind11::bytes chunk(m_buffer.data(), length);
+      m_target.attr("write")(chunk);
+    }
+    m_buffer.erase(0, length);
+  }
+
+  pybind11::object m_target;
+  complate::Stream *m_stream;
+  std::size_t m_threshold;
+  std::string m_buffer;
+};
+
+static const char BUFFEREDSTREAM_DOC_CLASS[] = R"DELIM(
+  Stream which collects output and forwards it in large chunks.
+
+  Views write many small fragments, calling into Python for every single one
+  of them is expensive. Wrap your Stream into a BufferedStream and it's only
+  called when the buffer exceeds the threshold and on flush(). The target can
+  also be any object with a write(bytes) method, like a file or io.BytesIO.
+  In that case every chunk is passed as a single bytes object. Output left in
+  the buffer is forwarded when the BufferedStream is destroyed, but errors
+  are only raised by flush().
+)DELIM";
+
+void registerBufferedStream(pybind11::module_ &m) {
+  namespace py = pybind11;
+  using namespace complate;
+
+  py::class_<BufferedStream, Stream>(m, "BufferedStream")
+      .def(py::init<py::object, std::size_t>(),
+           "Construct a BufferedStream, which forwards to target.",
+           py::arg("target"), py::arg("threshold") = 8192)
+      .def_property_readonly("buffered", &BufferedStream::buffered,
+                             "The number of bytes not forwarded yet.")
+      .doc() = BUFFEREDSTREAM_DOC_CLASS;
+}
@@ -0,0 +1,207 @@
+/**
+ * Copyright 2021 Torsten Mehnert
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+#pragma once
+
+#include <complate/core/renderer.h>
+#include <complate/core/stringstream.h>
+#include <pybind11/pybind11.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <list>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+#include "valuekey.h"
+
+/**
+ * Renderer which serves repeated renders of a view from a cache.
+ *
+ * The output is cached per view and parameters. Parameters are compared by
+ * their content, so parameters containing functions or Python objects can't
+ * be cached and are always rendered.
+ */
+class CachingRenderer : public complate::Renderer {
+public:
+  using Clock = std::chrono::steady_clock;
+
+  CachingRenderer(complate::Renderer &renderer, std::size_t maxEntries,
+                  std::size_t maxBytes, double ttl)
+      : m_renderer(renderer),
+        m_maxEntries(maxEntries),
+        m_maxBytes(maxBytes),
+        m_ttl(std::chrono::duration_cast<Clock::duration>(
+            std::chrono::duration<double>(ttl))) {}
+
+  void render(const std::string &view, const complate::Object &parameters,
+              complate::Stream &stream) override {
+    ValueKey key;
+    key.add(view);
+    if (!key.add(parameters)) {
+      ++m_bypasses;
+      m_renderer.render(view, parameters, stream);
+      return;
+    }
+    cached(key.take(), stream, [&](complate::Stream &capture) {
+      m_renderer.render(view, parameters, capture);
+    });
+  }
+
+  void render(const std::string &view, const std::string &parameters,
+              complate::Stream &stream) override {
+    ValueKey key;
+    key.add(view);
+    key.tag('j');
+    key.add(parameters);
+    cached(key.take(), stream, [&](complate::Stream &capture) {
+      m_renderer.render(view, parameters, capture);
+    });
+  }
+
+  void clear() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_entries.clear();
+    m_index.clear();
+    m_bytes = 0;
+  }
+
+  [[nodiscard]] pybind11::dict stats() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    pybind11::dict stats;
+    stats["hits"] = m_hits;
+    stats["misses"] = m_misses;
+    stats["bypasses"] = m_bypasses.load();
+    stats["entries"] = m_entries.size();
+    stats["bytes"] = m_bytes;
+    return stats;
+  }
+
+private:
+  struct Entry {
+    /** View and parameters, the index refers to it. */
+    std::string key;
+    std::string output;
+    Clock::time_point expires;
+
+    [[nodiscard]] std::size_t bytes() const {
+      return key.size() + output.size();
+    }
+  };
+
+  template <typename Render>
+  void cached(std::string key, complate::Stream &stream,
+              const Render &render) {
+    if (auto output = lookup(key)) {
+      stream.write(output->data(), static_cast<int>(output->size()));
+      stream.flush();
+      return;
+    }
+
+    complate::StringStream capture;
+    render(capture);
+    auto output = capture.str();
+    stream.write(output.data(), static_cast<int>(output.size()));
+    stream.flush();
+    store(std::move(key), std::move(output));
+  }
+
+  std::optional<std::string> lookup(const std::string &key) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_index.find(key);
+    if (it == m_index.end()) {
+      ++m_misses;
+      return std::nullopt;
+    }
+    auto entry = it->second;
+    if (m_ttl.count() > 0 && entry->expires <= Clock::now()) {
+      erase(entry);
+      ++m_misses;
+      return std::nullopt;
+    }
+    ++m_hits;
+    m_entries.splice(m_entries.begin(), m_entries, entry);
+    return entry->output;
+  }
+
+  void store(std::string key, std::string output) {
+    if (key.size() + output.size() > m_maxBytes || m_maxEntries == 0) {
+      return;
+    }
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_index.find(key);
+    if (it != m_index.end()) {
+      erase(it->second);
+    }
+    m_entries.push_front({std::move(key), std::move(output),
+                          Clock::now() + m_ttl});
+    m_bytes += m_entries.front().bytes();
+    m_index.emplace(m_entries.front().key, m_entries.begin());
+    while (m_entries.size() > m_maxEntries || m_bytes > m_maxBytes) {
+      erase(std::prev(m_entries.end()));
+    }
+  }
+
+  void erase(std::list<Entry>::iterator entry) {
+    m_bytes -= entry->bytes();
+    m_index.erase(entry->key);
+    m_entries.erase(entry);
+  }
+
+  complate::Renderer &m_renderer;
+  const std::size_t m_maxEntries;
+  const std::size_t m_maxBytes;
+  const Clock::duration m_ttl;
+  std::mutex m_mutex;
+  std::list<Entry> m_entries;
+  std::unordered_map<std::string_view, std::list<Entry>::iterator>
+      m_index;
+  std::size_t m_bytes = 0;
+  std::size_t m_hits = 0;
+  std::size_t m_misses = 0;
+  std::atomic<std::size_t> m_bypasses = 0;
+};
+
+static const char CACHING_RENDERER_DOC_CLASS[] = R"DELIM(
+  Renderer which caches the output of another renderer.
+
+  The output is cached per view and parameters, repeated renders are written
+  to the stream without running the view again. The cache holds at most
+  max_entries outputs with max_bytes in total, including the parameters
+  they were rendered with, and drops the least recently used first.
+  Outputs expire after ttl seconds, unless ttl is 0.
+  Parameters containing functions or objects of your own classes can't be
+  compared by their content, those renders are not cached.
+)DELIM";
+
+void registerCachingRenderer(pybind11::module_ &m) {
+  namespace py = pybind11;
+  using namespace complate;
+
+  py::class_<CachingRenderer, Renderer>(m, "CachingRenderer")
+      .def(py::init<Renderer &, std::size_t, std::size_t, double>(),
+           "Construct a CachingRenderer in front of renderer.",
+           py::keep_alive<1, 2>(), py::arg("renderer"),
+           py::arg("max_entries") = 1024, py::arg("max_bytes") = 16777216,
+           py::arg("ttl") = 0.0)
+      .def("stats", &CachingRenderer::stats,
+           "Get hits, misses, bypasses, entries and bytes of the cache.")
+      .def("clear", &CachingRenderer::clear, "Drop all cached outputs.")
+      .doc() = CACHING_RENDERER_DOC_CLASS;
+}
@@ -13,8 +13,12 @@
  *  See the License for the specific language governing permissions and
  *  limitations under the License.
  */
+#include "bufferedstream.h"
+#include "cachingrenderer.h"
+#include "dumpsparams.h"
 #include "function.h"
 #include "renderer.h"
+#include "segmentrenderer.h"
 #include "stream.h"
 #include "stringstream.h"
 #include "value.h"
@@ -26,5 +30,9 @@ PYBIND11_MODULE(core, m) {
   registerFunction(m);
   registerStream(m);
   registerStringStream(m);
+  registerBufferedStream(m);
   registerRenderer(m);
+  registerCachingRenderer(m);
+  registerSegmentRenderer(m);
+  registerDumpsParams(m);
 }
@@ -0,0 +1,40 @@
+/**
+ * Copyright 2021 Torsten Mehnert
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+#pragma once
+
+#include <pybind11/pybind11.h>
+
+#include "jsonwriter.h"
+
+static const char DUMPS_PARAMS_DOC[] = R"DELIM(
+  Serialize view parameters to UTF-8 encoded JSON.
+
+  Dicts, lists, tuples, str, int, float, bool and None are written like
+  json.dumps does, lone surrogates are escaped as \uXXXX. Objects of
+  dataclasses and other classes are written as objects holding their public
+  fields, slots, properties and attributes.
+  The result can be passed to a renderer as parameters directly, which saves
+  converting the parameters on every render when they are reused.
+)DELIM";
+
+void registerDumpsParams(pybind11::module_ &m) {
+  namespace py = pybind11;
+
+  m.def(
+      "dumps_params",
+      [](const py::handle &obj) { return py::bytes(JsonWriter::dumps(obj)); },
+      DUMPS_PARAMS_DOC, py::arg("obj"));
+}
@@ -16,10 +16,16 @@
 #pragma once
 
 #include <complate/core/renderer.h>
+#include <complate/core/stringstream.h>
 #include <pybind11/functional.h>
 #include <pybind11/pybind11.h>
 #include <pybind11/stl.h>
 
+#include "batch.h"
+#include "deadline.h"
+#include "renderbindings.h"
+#include "threadstate.h"
+
 static const char RENDERER_DOC_CLASS[] = R"DELIM(
   Renderer interface to get HTML output from a view and it's parameters.
 
@@ -27,6 +33,35 @@ static const char RENDERER_DOC_CLASS[] = R"DELIM(
   specific Renderer's behaviour.
   For actual Renderer implementations that really cause HTML output to be
   generated look at the implementations for JavaScript Engines like QuickJS.
+
+  JSON parameters can be passed as str, or as UTF-8 encoded bytes, bytearray
+  or memoryview, which are used without decoding them first.
+
+  When rendering with a dict, pass lazy=True to expose nested dicts lazily.
+  Their fields are converted when the view reads them, which is cheaper for
+  large parameters that are only used partly. This requires a renderer built
+  by the QuickJsRendererBuilder.
+
+  Pass as_json=True instead, to hand the dict over as JSON written to a
+  buffer reused by the thread. This avoids allocating each value of large
+  parameters separately, but works only for parameters dumps_params() can
+  serialize, which excludes functions.
+
+  Pass timeout_ms to abort a render, which takes longer than that. It
+  raises a TimeoutError. The deadline is checked whenever the view writes
+  to the stream or calls into Python, and by the interrupt handler of
+  QuickJS where the platform allows it. A pool stops waiting for a renderer
+  at the deadline in any case and replaces it, when it doesn't return.
+)DELIM";
+
+static const char RENDERER_DOC_BATCH[] = R"DELIM(
+  Render several views at once and get their output as list.
+
+  The items are pairs of view and parameters, which are a dict or a JSON
+  string. All parameters are converted first and the views are rendered one
+  after another within this single call. The outputs are str, or UTF-8
+  encoded bytes when as_bytes is set. A pool spreads the items across its
+  renderers.
 )DELIM";
 
 void registerRenderer(pybind11::module_ &m) {
@@ -34,26 +69,20 @@ void registerRenderer(pybind11::module_ &m) {
   using namespace std;
   using namespace complate;
 
-  py::class_<Renderer>(m, "Renderer")
-      .def("render",
-           py::overload_cast<const string &, const string &, Stream &>(
-               &Renderer::render),
-           "Render a view to a Stream using a JSON string as parameters.",
-           py::arg("view"), py::arg("parameters"), py::arg("stream"))
-      .def("render",
-           py::overload_cast<const string &, const Object &, Stream &>(
-               &Renderer::render),
-           "Render a view to a Stream using a dict as parameters.",
-           py::arg("view"), py::arg("parameters"), py::arg("stream"))
-      .def("render_tostring",
-           py::overload_cast<const string &, const string &>(
-               &Renderer::renderToString),
-           "Render a view to a Stream using a JSON string as parameters.",
-           py::arg("view"), py::arg("parameters"))
-      .def("render_tostring",
-           py::overload_cast<const string &, const Object &>(
-               &Renderer::renderToString),
-           "Render a view to a String using a dict as parameters.",
-           py::arg("view"), py::arg("parameters"))
-      .doc() = RENDERER_DOC_CLASS;
+  Deadline::registerTranslator();
+  m.attr("_thread_state") = ThreadState::capsule();
+
+  py::class_<Renderer> cls(m, "Renderer");
+  defineRender(cls);
+  cls.def(
+      "render_batch",
+      [](Renderer &renderer, const py::iterable &items, bool asBytes,
+         bool lazy) {
+        Batch batch(items, lazy);
+        batch.render(renderer);
+        return batch.outputs(asBytes);
+      },
+      RENDERER_DOC_BATCH, py::arg("items"), py::arg("as_bytes") = false,
+      py::arg("lazy") = false);
+  cls.doc() = RENDERER_DOC_CLASS;
 }
@@ -0,0 +1,304 @@
+/**
+ * Copyright 2021 Torsten Mehnert
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+#pragma once
+
+#include <complate/core/renderer.h>
+#include <complate/core/stringstream.h>
+#include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
+
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <variant>
+#include <vector>
+
+#include "mapper.h"
+#include "valuekey.h"
+
+/**
+ * Outputs of the segments of a page, as rendered the last time.
+ *
+ * A page belongs to one client, the changed segments of a render are
+ * computed against the previous render of the same page.
+ */
+class SegmentedPage {
+public:
+  /** The page of the last render. */
+  [[nodiscard]] std::string output() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::string page;
+    for (const auto &name : m_order) {
+      page.append(*m_outputs.at(name).output);
+    }
+    return page;
+  }
+
+  /** The output of a segment of the last render, if it was part of it. */
+  [[nodiscard]] std::optional<std::string> segment(const std::string &name) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_outputs.find(name);
+    if (it == m_outputs.end()) {
+      return std::nullopt;
+    }
+    return *it->second.output;
+  }
+
+  /** Forget the last render, so all segments are rendered again. */
+  void clear() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_outputs.clear();
+    m_order.clear();
+  }
+
+private:
+  friend class SegmentRenderer;
+
+  struct Output {
+    /** View and parameters, empty if they can't be compared. */
+    std::optional<std::string> key;
+    /** Shared with the snapshot taken by a render running meanwhile. */
+    std::shared_ptr<const std::string> output;
+  };
+
+  std::mutex m_mutex;
+  std::unordered_map<std::string, Output> m_outputs;
+  std::vector<std::string> m_order;
+};
+
+/**
+ * Renderer which renders a page from segments and re-renders only those
+ * whose view or parameters have changed since the last render of the page.
+ *
+ * Each segment is a view rendered on its own, like a top-level component of
+ * a dashboard. Its output is kept in the page together with its view and
+ * parameters, so unchanged segments are spliced into the page from the
+ * previous render. Parameters which can't be compared by their content, like
+ * functions, are always rendered. Without a page of their own, callers
+ * share the page of the renderer.
+ */
+class SegmentRenderer : public complate::Renderer {
+public:
+  struct Segment {
+    std::string name;
+    std::string view;
+    std::variant<complate::Object, std::string> parameters;
+  };
+
+  explicit SegmentRenderer(complate::Renderer &renderer)
+      : m_renderer(renderer), m_page(std::make_shared<SegmentedPage>()) {}
+
+  void render(const std::string &view, const complate::Object &parameters,
+              complate::Stream &stream) override {
+    m_renderer.render(view, parameters, stream);
+  }
+
+  void render(const std::string &view, const std::string &parameters,
+              complate::Stream &stream) override {
+    m_renderer.render(view, parameters, stream);
+  }
+
+  /**
+   * Render the segments in their order and write the page to stream.
+   *
+   * Returns the names of the segments, which were rendered anew or are no
+   * longer part of the page.
+   */
+  std::vector<std::string> renderSegments(const std::vector<Segment> &segments,
+                                          complate::Stream *stream,
+                                          SegmentedPage &page) {
+    using Output = SegmentedPage::Output;
+    std::unordered_map<std::string, Output> previous;
+    {
+      std::lock_guard<std::mutex> lock(page.m_mutex);
+      previous = page.m_outputs;
+    }
+
+    /* Render without the lock, views may call back into Python. */
+    std::unordered_map<std::string, Output> outputs;
+    std::vector<std::string> order;
+    std::vector<std::string> changed;
+    for (const auto &segment : segments) {
+      auto key = keyOf(segment);
+      auto it = previous.find(segment.name);
+      Output output;
+      if (key && it != previous.end() && it->second.key == key) {
+        output = std::move(it->second);
+      } else {
+        output = {std::move(key), std::make_shared<const std::string>(
+                                      renderSegment(segment))};
+        changed.push_back(segment.name);
+      }
+      if (!outputs.emplace(segment.name, std::move(output)).second) {
+        throw std::invalid_argument("Segment names must be unique, got " +
+                                    segment.name + " twice");
+      }
+      order.push_back(segment.name);
+      previous.erase(segment.name);
+    }
+    for (const auto &removed : previous) {
+      changed.push_back(removed.first);
+    }
+
+    if (stream) {
+      for (const auto &name : order) {
+        const auto &output = *outputs.at(name).output;
+        stream->write(output.data(), static_cast<int>(output.size()));
+      }
+      stream->flush();
+    }
+
+    std::lock_guard<std::mutex> lock(page.m_mutex);
+    page.m_outputs = std::move(outputs);
+    page.m_order = std::move(order);
+    return changed;
+  }
+
+  /** The page used by callers without a page of their own. */
+  [[nodiscard]] SegmentedPage &page() { return *m_page; }
+
+private:
+  static std::optional<std::string> keyOf(const Segment &segment) {
+    ValueKey key;
+    key.add(segment.view);
+    if (auto object = std::get_if<complate::Object>(&segment.parameters)) {
+      if (!key.add(*object)) {
+        return std::nullopt;
+      }
+    } else {
+      key.tag('j');
+      key.add(std::get<std::string>(segment.parameters));
+    }
+    return key.take();
+  }
+
+  std::string renderSegment(const Segment &segment) {
+    complate::StringStream capture;
+    std::visit(
+        [&](const auto &parameters) {
+          m_renderer.render(segment.view, parameters, capture);
+        },
+        segment.parameters);
+    return capture.str();
+  }
+
+  complate::Renderer &m_renderer;
+  std::shared_ptr<SegmentedPage> m_page;
+};
+
+static const char SEGMENT_RENDERER_DOC_CLASS[] = R"DELIM(
+  Renderer which re-renders only the changed segments of a page.
+
+  A page is passed as a list of (name, view, parameters) segments, like the
+  top-level components of a dashboard. Parameters are a dict or JSON. The
+  output of every segment is kept, so the next render runs only the views of
+  segments whose view or parameters have changed, and splices the output of
+  the others from the previous render. Segments with parameters containing
+  functions or objects of your own classes are always rendered.
+
+  The previous render is kept in a SegmentedPage. Pass a page per client to
+  render_segments(), when the renderer serves several clients. Otherwise
+  they share the page of the renderer and changes are computed against
+  whichever client rendered last.
+)DELIM";
+
+static const char SEGMENTED_PAGE_DOC_CLASS[] = R"DELIM(
+  The outputs of the segments of a page, as rendered the last time.
+
+  Keep one page per client and pass it to SegmentRenderer.render_segments().
+)DELIM";
+
+static const char SEGMENT_RENDERER_DOC_RENDER_SEGMENTS[] = R"DELIM(
+  Render the segments in their order and write the page to stream.
+
+  Returns the names of the segments, which were rendered anew or are no
+  longer part of the page, to send partial updates to your clients. The
+  stream may be omitted, when you only need those and use segment() or
+  output() to get their output. The previous render is taken from page and
+  the render is stored there, the page of the renderer is used without one.
+)DELIM";
+
+void registerSegmentRenderer(pybind11::module_ &m) {
+  namespace py = pybind11;
+  using namespace std;
+  using namespace complate;
+
+  py::class_<SegmentedPage>(m, "SegmentedPage")
+      .def(py::init<>(), "Construct an empty page.")
+      .def("output", &SegmentedPage::output,
+           "Get the page of the last render.")
+      .def("segment", &SegmentedPage::segment,
+           "Get the output of a segment of the last render, or None.",
+           py::arg("name"))
+      .def("clear", &SegmentedPage::clear,
+           "Forget the last render, so all segments are rendered again.")
+      .doc() = SEGMENTED_PAGE_DOC_CLASS;
+
+  py::class_<SegmentRenderer, Renderer>(m, "SegmentRenderer")
+      .def(py::init<Renderer &>(),
+           "Construct a SegmentRenderer in front of renderer.",
+           py::keep_alive<1, 2>(), py::arg("renderer"))
+      .def(
+          "render_segments",
+          [](SegmentRenderer &renderer, const py::iterable &items,
+             Stream *stream, SegmentedPage *page) {
+            vector<SegmentRenderer::Segment> segments;
+            for (const auto &item : items) {
+              auto triple = py::reinterpret_borrow<py::sequence>(item);
+              if (triple.size() != 3) {
+                throw invalid_argument(
+                    "A segment must be a triple of name, view and parameters");
+              }
+              py::object parameters = triple[2];
+              SegmentRenderer::Segment segment{triple[0].cast<string>(),
+                                               triple[1].cast<string>(),
+                                               Object()};
+              if (py::isinstance<py::dict>(parameters)) {
+                segment.parameters =
+                    Mapper::python_to_object(parameters.cast<py::dict>());
+              } else if (py::isinstance<py::str>(parameters)) {
+                segment.parameters = parameters.cast<string>();
+              } else {
+                segment.parameters = Mapper::buffer_to_string(parameters);
+              }
+              segments.push_back(move(segment));
+            }
+            return renderer.renderSegments(
+                segments, stream, page ? *page : renderer.page());
+          },
+          SEGMENT_RENDERER_DOC_RENDER_SEGMENTS, py::arg("segments"),
+          py::arg("stream") = nullptr, py::arg("page") = nullptr)
+      .def(
+          "output",
+          [](SegmentRenderer &renderer) { return renderer.page().output(); },
+          "Get the page of the last render without a page of its own.")
+      .def(
+          "segment",
+          [](SegmentRenderer &renderer, const string &name) {
+            return renderer.page().segment(name);
+          },
+          "Get the output of a segment of the last render without a page of "
+          "its own, or None.",
+          py::arg("name"))
+      .def(
+          "clear", [](SegmentRenderer &renderer) { renderer.page().clear(); },
+          "Forget the last render without a page of its own.")
+      .doc() = SEGMENT_RENDERER_DOC_CLASS;
+}
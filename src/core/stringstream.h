@@ -21,7 +21,10 @@
 static const char STRINGSTREAM_DOC_CLASS[] = R"DELIM(
   Stream which stores rendered output as a string.
 
-  Use str() to get the rendered output.
+  Use str() to get the rendered output, or buffer() to get it as UTF-8
+  encoded bytes. Both copy the output twice, once out of the stream and once
+  into the Python object. render_tostring() and render_tobytes() copy it
+  once, prefer them when you don't need a stream.
 )DELIM";
 
 void registerStringStream(pybind11::module_ &m) {
@@ -31,5 +34,9 @@ void registerStringStream(pybind11::module_ &m) {
   py::class_<StringStream, Stream>(m, "StringStream")
       .def(py::init<>(), "Construct a StringStream.")
       .def("str", &StringStream::str, "Get the rendered output.")
+      .def(
+          "buffer",
+          [](const StringStream &stream) { return py::bytes(stream.str()); },
+          "Get the rendered output as bytes, without decoding it.")
       .doc() = STRINGSTREAM_DOC_CLASS;
 }
@@ -19,6 +19,8 @@
 #include <pybind11/pybind11.h>
 #include <pybind11/stl.h>
 
+#include "mapper.h"
+
 static const char VALUE_DOC_CLASS[] = R"DELIM(
   Javascript compatible Value.
 
@@ -36,37 +38,9 @@ void registerValue(pybind11::module_ &m) {
 
   py::class_<Value>(m, "Value")
       .def(py::init([](const py::object &obj) {
-        if (py::isinstance<py::none>(obj)) {
-          return Value(nullptr);
-        }
-        if (py::isinstance<py::str>(obj)) {
-          return Value(py::cast<string>(obj));
-        }
-        if (py::isinstance<py::bool_>(obj)) {
-          return Value(py::cast<bool>(obj));
-        }
-        if (py::isinstance<py::int_>(obj)) {
-          return Value(py::cast<int64_t>(obj));
-        }
-        if (py::isinstance<py::float_>(obj)) {
-          return Value(py::cast<double>(obj));
-        }
-        if (py::isinstance<py::list>(obj)) {
-          return Value(py::cast<Array>(obj));
-        }
-        if (py::isinstance<py::dict>(obj)) {
-          return Value(py::cast<Object>(obj));
-        }
-        if (py::isinstance<py::function>(obj)) {
-          return Value(Function([obj](const Array &args) -> Value {
-            auto tup = Mapper::args_to_tuple(args);
-            return obj(*tup).cast<Value>();
-          }));
-        }
-        auto name = obj.attr("__class__").attr("__name__").cast<string>();
-        auto pptr = make_shared<py::object>(obj);
-        return Value(Proxy(name, pptr));
-      }), "Construct a javascript compatible value, called implicitly.")
+             return Mapper::python_to_value(obj);
+           }),
+           "Construct a javascript compatible value, called implicitly.")
       .def("get_function",
            [](const Value &v) { return v.optional<Function>(); })
       .doc() = VALUE_DOC_CLASS;
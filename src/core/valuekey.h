@@ -0,0 +1,102 @@
+/**
+ * Copyright 2021 Torsten Mehnert
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+#pragma once
+
+#include <complate/core/value.h>
+
+#include <cstdint>
+#include <string>
+
+/**
+ * Canonical encoding of view parameters, to compare them by their content.
+ *
+ * Equal parameters give equal keys, different parameters different keys, so
+ * keys are compared instead of the parameters themselves. Values which can't
+ * be compared by their content, like functions and proxies of Python
+ * objects, make add() return false.
+ */
+class ValueKey {
+public:
+  bool add(const complate::Value &value) {
+    using namespace complate;
+    if (value.holds<Null>()) {
+      tag('n');
+    } else if (value.holds<Bool>()) {
+      tag(value.exactly<Bool>() ? 't' : 'f');
+    } else if (value.holds<Number>()) {
+      const auto &number = value.exactly<Number>();
+      double d = 0;
+      if (number.holds<int32_t>()) {
+        d = number.exactly<int32_t>();
+      } else if (number.holds<uint32_t>()) {
+        d = number.exactly<uint32_t>();
+      } else if (number.holds<int64_t>()) {
+        d = static_cast<double>(number.exactly<int64_t>());
+      } else if (number.holds<double>()) {
+        d = number.exactly<double>();
+      }
+      tag('d');
+      bytes(&d, sizeof(d));
+    } else if (value.holds<String>()) {
+      tag('s');
+      add(value.exactly<String>().get<std::string>());
+    } else if (value.holds<Array>()) {
+      const auto &array = value.exactly<Array>();
+      tag('a');
+      size(array.size());
+      for (const auto &item : array) {
+        if (!add(item)) {
+          return false;
+        }
+      }
+    } else if (value.holds<Object>()) {
+      return add(value.exactly<Object>());
+    } else {
+      return false;
+    }
+    return true;
+  }
+
+  bool add(const complate::Object &object) {
+    tag('o');
+    size(object.size());
+    for (const auto &[key, member] : object) {
+      add(key);
+      if (!add(member)) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  void add(const std::string &str) {
+    size(str.size());
+    bytes(str.data(), str.size());
+  }
+
+  /** Mark the kind of what is added next. */
+  void tag(char c) { m_key.push_back(c); }
+
+  [[nodiscard]] std::string take() { return std::move(m_key); }
+
+private:
+  void size(uint64_t size) { bytes(&size, sizeof(size)); }
+  void bytes(const void *data, std::size_t len) {
+    m_key.append(static_cast<const char *>(data), len);
+  }
+
+  std::string m_key;
+};
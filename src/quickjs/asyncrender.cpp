@@ -0,0 +1,107 @@
+/**
+ * Copyright 2021 Torsten Mehnert
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+#include "asyncrender.h"
+
+#include <stdexcept>
+
+#include "deadline.h"
+#include "gil.h"
+#include "outputstream.h"
+
+using namespace std;
+using namespace complate;
+namespace py = pybind11;
+
+namespace {
+struct Outcome {
+  string output;
+  exception_ptr error;
+};
+
+template <typename Parameters>
+py::object render(RendererPool &pool, string view, Parameters parameters,
+                  bool asBytes) {
+  auto loop = py::module_::import("asyncio").attr("get_running_loop")();
+  auto future = loop.attr("create_future")();
+  auto outcome = make_shared<Outcome>();
+  auto resolve = Gil::share(py::cpp_function([future, outcome, asBytes]() {
+    if (future.attr("done")().cast<bool>()) {
+      return;
+    }
+    if (outcome->error) {
+      AsyncRender::setException(future, outcome->error);
+    } else if (asBytes) {
+      future.attr("set_result")(py::bytes(outcome->output));
+    } else {
+      future.attr("set_result")(py::str(outcome->output));
+    }
+  }));
+  auto sharedLoop = Gil::share(loop);
+
+  pool.submit([&pool, sharedLoop, resolve, outcome, view = move(view),
+               parameters = move(parameters)](Renderer &renderer) {
+    try {
+      OutputStream stream;
+      pool.renderWithTimeout(stream, [&](Stream &out) {
+        renderer.render(view, parameters, out);
+      });
+      outcome->output = stream.take();
+    } catch (...) {
+      outcome->error = current_exception();
+    }
+    AsyncRender::callSoon(sharedLoop, resolve);
+  });
+  return future;
+}
+}  // namespace
+
+py::object AsyncRender::start(RendererPool &pool, string view,
+                              Object parameters, bool asBytes) {
+  return render(pool, move(view), move(parameters), asBytes);
+}
+
+py::object AsyncRender::start(RendererPool &pool, string view,
+                              string parameters, bool asBytes) {
+  return render(pool, move(view), move(parameters), asBytes);
+}
+
+void AsyncRender::callSoon(const shared_ptr<py::object> &loop,
+                           const shared_ptr<py::object> &callback) {
+  py::gil_scoped_acquire acquire;
+  try {
+    loop->attr("call_soon_threadsafe")(*callback);
+  } catch (py::error_already_set &) {
+  }
+}
+
+void AsyncRender::setException(const py::object &future,
+                               exception_ptr error) {
+  try {
+    rethrow_exception(error);
+  } catch (py::error_already_set &e) {
+    future.attr("set_exception")(e.value());
+  } catch (const RenderTimeout &e) {
+    /* Raised like renders without a future raise it. */
+    future.attr("set_exception")(
+        py::handle(PyExc_TimeoutError)(py::str(e.what())));
+  } catch (const invalid_argument &e) {
+    future.attr("set_exception")(
+        py::handle(PyExc_ValueError)(py::str(e.what())));
+  } catch (const exception &e) {
+    future.attr("set_exception")(
+        py::handle(PyExc_RuntimeError)(py::str(e.what())));
+  }
+}
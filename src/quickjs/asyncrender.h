@@ -0,0 +1,55 @@
+/**
+ * Copyright 2021 Torsten Mehnert
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+#pragma once
+
+#include <complate/core/renderer.h>
+#include <pybind11/pybind11.h>
+
+#include <exception>
+#include <memory>
+#include <string>
+
+#include "rendererpool.h"
+
+/** Renders on a pool and completes asyncio futures with the output. */
+class AsyncRender {
+public:
+  AsyncRender() = delete;
+
+  /**
+   * Start a render on the pool and return an asyncio future of its output.
+   *
+   * The future is completed on its event loop, the loop is never blocked
+   * while the view renders.
+   */
+  static pybind11::object start(RendererPool &pool, std::string view,
+                                complate::Object parameters, bool asBytes);
+  static pybind11::object start(RendererPool &pool, std::string view,
+                                std::string parameters, bool asBytes);
+
+  /**
+   * Schedule a callback on an event loop from any thread.
+   *
+   * Errors are ignored, they occur when the loop has been closed meanwhile
+   * and nobody is waiting for the callback anymore.
+   */
+  static void callSoon(const std::shared_ptr<pybind11::object> &loop,
+                       const std::shared_ptr<pybind11::object> &callback);
+
+  /** Fail a future with an error thrown by a render. */
+  static void setException(const pybind11::object &future,
+                           std::exception_ptr error);
+};
@@ -0,0 +1,216 @@
+/**
+ * Copyright 2021 Torsten Mehnert
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+#include "bytecodecache.h"
+
+#include <pybind11/pybind11.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <system_error>
+
+#ifdef COMPLATECPP_RUNTIME_HOOK
+#include <quickjs.h>
+#endif
+
+using namespace std;
+namespace fs = std::filesystem;
+namespace py = pybind11;
+
+namespace {
+thread_local BytecodeCache *usedCache = nullptr;
+thread_local const string *usedSource = nullptr;
+thread_local bool usedEvaluated = false;
+
+/** FNV-1a hash and size of the source, which name its bytecode file. */
+string keyOf(string_view source) {
+  uint64_t hash = 14695981039346656037ull;
+  for (unsigned char c : source) {
+    hash ^= c;
+    hash *= 1099511628211ull;
+  }
+  char key[40];
+  snprintf(key, sizeof(key), "%016llx-%zu",
+           static_cast<unsigned long long>(hash), source.size());
+  return key;
+}
+}  // namespace
+
+#ifdef COMPLATECPP_RUNTIME_HOOK
+extern "C" {
+JSValue __real_JS_Eval(JSContext *ctx, const char *input, size_t input_len,
+                       const char *filename, int eval_flags);
+
+JSValue __wrap_JS_Eval(JSContext *ctx, const char *input, size_t input_len,
+                       const char *filename, int eval_flags) {
+  string_view source(input, input_len);
+  auto cache = BytecodeCache::used(source);
+  if (!cache || (eval_flags & JS_EVAL_TYPE_MASK) != JS_EVAL_TYPE_GLOBAL ||
+      (eval_flags & JS_EVAL_FLAG_COMPILE_ONLY)) {
+    return __real_JS_Eval(ctx, input, input_len, filename, eval_flags);
+  }
+
+  auto compile = [&]() -> optional<string> {
+    JSValue function = __real_JS_Eval(ctx, input, input_len, filename,
+                                      eval_flags | JS_EVAL_FLAG_COMPILE_ONLY);
+    if (JS_IsException(function)) {
+      JS_FreeValue(ctx, JS_GetException(ctx));
+      return nullopt;
+    }
+    size_t size = 0;
+    uint8_t *data =
+        JS_WriteObject(ctx, &size, function, JS_WRITE_OBJ_BYTECODE);
+    JS_FreeValue(ctx, function);
+    if (!data) {
+      JS_FreeValue(ctx, JS_GetException(ctx));
+      return nullopt;
+    }
+    string bytecode(reinterpret_cast<const char *>(data), size);
+    js_free(ctx, data);
+    return bytecode;
+  };
+
+  /* Retried once, after bytecode of another QuickJS version was dropped. */
+  for (int attempt = 0; attempt < 2; ++attempt) {
+    auto bytecode = cache->get(source, compile);
+    if (!bytecode) {
+      break;
+    }
+    JSValue function = JS_ReadObject(
+        ctx, reinterpret_cast<const uint8_t *>(bytecode->data()),
+        bytecode->size(), JS_READ_OBJ_BYTECODE);
+    if (!JS_IsException(function)) {
+      return JS_EvalFunction(ctx, function);
+    }
+    JS_FreeValue(ctx, JS_GetException(ctx));
+    cache->drop(source);
+  }
+  /* Reports errors, like a SyntaxError, as complate expects them. */
+  return __real_JS_Eval(ctx, input, input_len, filename, eval_flags);
+}
+}
+#endif
+
+BytecodeCache::BytecodeCache(string directory)
+    : m_directory(move(directory)) {}
+
+BytecodeCache::Use::Use(BytecodeCache &cache, const string &source)
+    : m_cache(usedCache), m_source(usedSource), m_evaluated(usedEvaluated) {
+  usedCache = &cache;
+  usedSource = &source;
+  usedEvaluated = false;
+}
+
+BytecodeCache::Use::~Use() {
+  usedCache = m_cache;
+  usedSource = m_source;
+  usedEvaluated = m_evaluated;
+}
+
+bool BytecodeCache::Use::evaluated() const { return usedEvaluated; }
+
+BytecodeCache *BytecodeCache::used(string_view source) {
+  if (!usedCache || *usedSource != source) {
+    return nullptr;
+  }
+  usedEvaluated = true;
+  return usedCache;
+}
+
+shared_ptr<const string> BytecodeCache::get(string_view source,
+                                            const Compile &compile) {
+  auto key = keyOf(source);
+  shared_ptr<const string> compiled;
+  {
+    lock_guard<mutex> lock(m_mutex);
+    if (m_key == key && m_bytecode) {
+      return m_bytecode;
+    }
+    if (m_key != key || !m_dropped) {
+      if (auto bytecode = read(key)) {
+        m_key = key;
+        m_bytecode = bytecode;
+        m_dropped = false;
+        return bytecode;
+      }
+    }
+    auto bytecode = compile();
+    if (!bytecode) {
+      return nullptr;
+    }
+    compiled = make_shared<const string>(move(*bytecode));
+    m_key = key;
+    m_bytecode = compiled;
+    m_dropped = false;
+  }
+  write(key, *compiled);
+  return compiled;
+}
+
+void BytecodeCache::drop(string_view source) {
+  lock_guard<mutex> lock(m_mutex);
+  m_key = keyOf(source);
+  m_bytecode.reset();
+  m_dropped = true;
+}
+
+shared_ptr<const string> BytecodeCache::read(const string &key) const {
+  if (m_directory.empty()) {
+    return nullptr;
+  }
+  ifstream file(path(key), ios::binary);
+  if (!file) {
+    return nullptr;
+  }
+  stringstream content;
+  content << file.rdbuf();
+  return make_shared<const string>(content.str());
+}
+
+void BytecodeCache::write(const string &key, const string &bytecode) const {
+  if (m_directory.empty()) {
+    return;
+  }
+  /* Written aside and renamed, so readers never see a partial file. */
+  auto target = path(key);
+  auto temporary = target + "." + to_string(random_device()()) + ".tmp";
+  error_code error;
+  {
+    ofstream file(temporary, ios::binary | ios::trunc);
+    file.write(bytecode.data(), static_cast<streamsize>(bytecode.size()));
+    if (!file) {
+      error = make_error_code(errc::io_error);
+    }
+  }
+  if (!error) {
+    fs::rename(temporary, target, error);
+  }
+  if (error) {
+    fs::remove(temporary, error);
+    py::gil_scoped_acquire acquire;
+    auto message = "Can't write the bytecode cache '" + target + "'";
+    if (PyErr_WarnEx(PyExc_RuntimeWarning, message.c_str(), 1) < 0) {
+      PyErr_WriteUnraisable(nullptr);
+    }
+  }
+}
+
+string BytecodeCache::path(const string &key) const {
+  return (fs::path(m_directory) / ("views-" + key + ".qjsbc")).string();
+}
@@ -0,0 +1,86 @@
+/**
+ * Copyright 2021 Torsten Mehnert
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+
+/**
+ * QuickJS bytecode of the views, compiled once and shared by renderers.
+ *
+ * complate evaluates the source of every renderer with JS_Eval. The runtime
+ * hook links the module with --wrap=JS_Eval as well, and answers the
+ * evaluation of a source passed to Use from the cache: the first renderer
+ * compiles the source to bytecode, the others read it. With a directory,
+ * the bytecode is also stored in a file named after a hash of the source, so
+ * later processes skip compiling as well. QuickJS doesn't verify bytecode,
+ * so the directory must not be writable by anyone you don't trust.
+ */
+class BytecodeCache {
+public:
+  using Compile = std::function<std::optional<std::string>()>;
+
+  /** Keep the bytecode in memory only, for an empty directory. */
+  explicit BytecodeCache(std::string directory);
+
+  /** Evaluations of the source on this thread use the cache while alive. */
+  class Use {
+  public:
+    Use(BytecodeCache &cache, const std::string &source);
+    ~Use();
+    Use(const Use &) = delete;
+    Use &operator=(const Use &) = delete;
+
+    /** Whether the source has been evaluated meanwhile. */
+    [[nodiscard]] bool evaluated() const;
+
+  private:
+    BytecodeCache *m_cache;
+    const std::string *m_source;
+    bool m_evaluated;
+  };
+
+  /** The cache to evaluate the source with on this thread, or nullptr. */
+  [[nodiscard]] static BytecodeCache *used(std::string_view source);
+
+  /**
+   * Bytecode of the source, from memory, the directory or compile().
+   *
+   * Concurrent calls compile the source only once. nullptr, when compile()
+   * returned none.
+   */
+  [[nodiscard]] std::shared_ptr<const std::string> get(
+      std::string_view source, const Compile &compile);
+
+  /** Forget the bytecode of the source, which QuickJS couldn't read. */
+  void drop(std::string_view source);
+
+private:
+  [[nodiscard]] std::shared_ptr<const std::string> read(
+      const std::string &key) const;
+  void write(const std::string &key, const std::string &bytecode) const;
+  [[nodiscard]] std::string path(const std::string &key) const;
+
+  const std::string m_directory;
+  std::mutex m_mutex;
+  std::string m_key;
+  std::shared_ptr<const std::string> m_bytecode;
+  bool m_dropped = false;
+};
@@ -0,0 +1,125 @@
+/**
+ * Copyright 2021 Torsten Mehnert
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+#include "chunkqueue.h"
+
+#include <stdexcept>
+
+using namespace std;
+
+ChunkQueue::ChunkQueue(size_t chunkSize, size_t capacity)
+    : m_chunkSize(max<size_t>(chunkSize, 1)),
+      m_capacity(max<size_t>(capacity, 1)) {
+  m_buffer.reserve(m_chunkSize);
+}
+
+void ChunkQueue::write(const char *str, int len) {
+  m_buffer.append(str, len);
+  if (m_buffer.size() >= m_chunkSize) {
+    enqueue(false);
+  }
+}
+
+void ChunkQueue::writeln(const char *str, int len) {
+  m_buffer.append(str, len);
+  m_buffer.push_back('\n');
+  if (m_buffer.size() >= m_chunkSize) {
+    enqueue(false);
+  }
+}
+
+void ChunkQueue::flush() { enqueue(false); }
+
+void ChunkQueue::close(exception_ptr error) {
+  if (!error) {
+    enqueue(true);
+  }
+
+  function<void()> callback;
+  {
+    lock_guard<mutex> lock(m_mutex);
+    m_error = move(error);
+    m_closed = true;
+    swap(callback, m_callback);
+  }
+  m_changed.notify_all();
+  if (callback) {
+    callback();
+  }
+}
+
+optional<string> ChunkQueue::next() {
+  unique_lock<mutex> lock(m_mutex);
+  m_changed.wait(lock, [this] { return ready(); });
+  if (!m_chunks.empty()) {
+    auto chunk = move(m_chunks.front());
+    m_chunks.pop_front();
+    lock.unlock();
+    m_changed.notify_all();
+    return chunk;
+  }
+  if (m_error) {
+    rethrow_exception(m_error);
+  }
+  return nullopt;
+}
+
+void ChunkQueue::notify(function<void()> callback) {
+  {
+    lock_guard<mutex> lock(m_mutex);
+    if (!ready()) {
+      m_callback = move(callback);
+      return;
+    }
+  }
+  callback();
+}
+
+void ChunkQueue::cancel() {
+  function<void()> callback;
+  {
+    lock_guard<mutex> lock(m_mutex);
+    m_cancelled = true;
+    swap(callback, m_callback);
+  }
+  m_changed.notify_all();
+}
+
+void ChunkQueue::enqueue(bool force) {
+  if (m_buffer.empty()) {
+    return;
+  }
+
+  function<void()> callback;
+  {
+    unique_lock<mutex> lock(m_mutex);
+    m_changed.wait(lock, [this, force] {
+      return force || m_cancelled || m_chunks.size() < m_capacity;
+    });
+    if (m_cancelled) {
+      throw runtime_error("Rendering cancelled, the output is not consumed");
+    }
+    m_chunks.push_back(move(m_buffer));
+    swap(callback, m_callback);
+  }
+  m_buffer = string();
+  m_buffer.reserve(m_chunkSize);
+  m_changed.notify_all();
+  if (callback) {
+    callback();
+  }
+}
+
+bool ChunkQueue::ready() const { return !m_chunks.empty() || m_closed; }
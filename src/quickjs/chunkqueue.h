@@ -0,0 +1,69 @@
+/**
+ * Copyright 2021 Torsten Mehnert
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+#pragma once
+
+#include <complate/core/stream.h>
+
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <string>
+
+/**
+ * Stream which hands the output over to another thread in chunks.
+ *
+ * The renderer writes into it from a worker thread, while the consumer takes
+ * the chunks out as soon as they are available. Only a limited number of
+ * chunks is queued, the renderer waits when the consumer can't keep up.
+ */
+class ChunkQueue : public complate::Stream {
+public:
+  ChunkQueue(std::size_t chunkSize, std::size_t capacity);
+
+  void write(const char *str, int len) override;
+  void writeln(const char *str, int len) override;
+  void flush() override;
+
+  /** Mark the end of the output, pass the error if rendering failed. */
+  void close(std::exception_ptr error);
+
+  /** Wait for the next chunk, nothing is returned at the end. */
+  std::optional<std::string> next();
+
+  /** Call back once, when the next chunk or the end is available. */
+  void notify(std::function<void()> callback);
+
+  /** The consumer is gone, further writes will abort the render. */
+  void cancel();
+
+private:
+  void enqueue(bool force);
+  [[nodiscard]] bool ready() const;
+
+  const std::size_t m_chunkSize;
+  const std::size_t m_capacity;
+  std::string m_buffer;
+  std::mutex m_mutex;
+  std::condition_variable m_changed;
+  std::deque<std::string> m_chunks;
+  std::function<void()> m_callback;
+  std::exception_ptr m_error;
+  bool m_closed = false;
+  bool m_cancelled = false;
+};
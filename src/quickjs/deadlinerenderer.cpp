@@ -0,0 +1,61 @@
+/**
+ * Copyright 2021 Torsten Mehnert
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+#include "deadlinerenderer.h"
+
+#include "deadline.h"
+
+using namespace std;
+using namespace complate;
+
+DeadlineRenderer::DeadlineRenderer(RendererPool::Creator creator,
+                                   double timeoutMs)
+    : m_creator(move(creator)),
+      m_renderer(m_creator()),
+      m_timeoutMs(timeoutMs) {}
+
+void DeadlineRenderer::render(const string &view, const Object &parameters,
+                              Stream &stream) {
+  renderWithin(view, parameters, stream);
+}
+
+void DeadlineRenderer::render(const string &view, const string &parameters,
+                              Stream &stream) {
+  renderWithin(view, parameters, stream);
+}
+
+template <typename Parameters>
+void DeadlineRenderer::renderWithin(const string &view,
+                                    const Parameters &parameters,
+                                    Stream &stream) {
+  /* A deadline passed for this render takes precedence over the default. */
+  optional<Deadline::Clock::time_point> at;
+  if (!Deadline::current().at) {
+    at = Deadline::after(m_timeoutMs);
+  }
+  try {
+    Deadline::run(at, [&] {
+      DeadlineStream checked(stream);
+      m_renderer->render(view, parameters, checked);
+    });
+  } catch (const RenderTimeout &) {
+    /* Keep the old renderer, when a new one can't be created. */
+    try {
+      m_renderer = m_creator();
+    } catch (...) {
+    }
+    throw;
+  }
+}
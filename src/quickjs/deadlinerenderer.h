@@ -0,0 +1,48 @@
+/**
+ * Copyright 2021 Torsten Mehnert
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+#pragma once
+
+#include <complate/core/renderer.h>
+
+#include <memory>
+
+#include "rendererpool.h"
+
+/**
+ * Renderer which aborts renders exceeding a default timeout.
+ *
+ * The timeout applies to renders without a deadline of their own. A renderer
+ * interrupted by a deadline is replaced by a new one, because the view was
+ * left at an arbitrary point.
+ */
+class DeadlineRenderer : public complate::Renderer {
+public:
+  DeadlineRenderer(RendererPool::Creator creator, double timeoutMs);
+
+  void render(const std::string &view, const complate::Object &parameters,
+              complate::Stream &stream) override;
+  void render(const std::string &view, const std::string &parameters,
+              complate::Stream &stream) override;
+
+private:
+  template <typename Parameters>
+  void renderWithin(const std::string &view, const Parameters &parameters,
+                    complate::Stream &stream);
+
+  RendererPool::Creator m_creator;
+  std::unique_ptr<complate::Renderer> m_renderer;
+  const double m_timeoutMs;
+};
@@ -0,0 +1,192 @@
+/**
+ * Copyright 2021 Torsten Mehnert
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+#include "frozenbindings.h"
+
+#include "mapper.h"
+
+using namespace std;
+using namespace complate;
+
+namespace {
+/** Global listing the names of the frozen bindings for the views. */
+const char NAMES[] = "__complatecppFrozen";
+
+using Node = Mapper::FrozenNode;
+
+Value expose(const shared_ptr<const Value> &root, const Value &value) {
+  if (value.holds<Object>()) {
+    auto node = make_shared<Node>(Node{root, &value.exactly<Object>()});
+    return Value(Proxy(Mapper::FROZEN, node));
+  }
+  if (value.holds<Array>()) {
+    const auto &items = value.exactly<Array>();
+    Array array;
+    array.reserve(items.size());
+    for (const auto &item : items) {
+      array.emplace_back(expose(root, item));
+    }
+    return Value(move(array));
+  }
+  return value;
+}
+}  // namespace
+
+const char *const FrozenBindings::JS = R"DELIM(
+;(function (global) {
+  function isFrozen(value) {
+    return value !== null && typeof value === "object" &&
+        typeof value.__frozenKeys === "function";
+  }
+
+  function unwrap(value) {
+    if (isFrozen(value)) {
+      return frozen(value);
+    }
+    if (Array.isArray(value)) {
+      return Object.freeze(value.map(unwrap));
+    }
+    return value;
+  }
+
+  function readOnly() {
+    throw new TypeError("frozen bindings are read-only");
+  }
+
+  function frozen(node) {
+    var target = {};
+    var keys = null;
+    var known = Object.create(null);
+    function ownKeys() {
+      if (keys === null) {
+        keys = node.__frozenKeys();
+      }
+      return keys;
+    }
+    function has(key) {
+      if (typeof key !== "string") {
+        return false;
+      }
+      if (!(key in known)) {
+        known[key] = node.__frozenHas(key);
+      }
+      return known[key];
+    }
+    function load(key) {
+      if (!Object.prototype.hasOwnProperty.call(target, key)) {
+        target[key] = unwrap(node.__frozenGet(key));
+      }
+      return target[key];
+    }
+    return new Proxy(target, {
+      get: function (t, key, receiver) {
+        return has(key) ? load(key) : Reflect.get(t, key, receiver);
+      },
+      has: function (t, key) {
+        return has(key) || key in t;
+      },
+      ownKeys: function () {
+        return ownKeys().slice();
+      },
+      getOwnPropertyDescriptor: function (t, key) {
+        if (!has(key)) {
+          return Reflect.getOwnPropertyDescriptor(t, key);
+        }
+        load(key);
+        return Reflect.getOwnPropertyDescriptor(t, key);
+      },
+      set: readOnly,
+      deleteProperty: readOnly,
+      defineProperty: readOnly
+    });
+  }
+
+  function wrapGlobals() {
+    var names = global.__complatecppFrozen;
+    if (!Array.isArray(names)) {
+      return false;
+    }
+    delete global.__complatecppFrozen;
+    names.forEach(function (name) {
+      global[name] = unwrap(global[name]);
+    });
+    return true;
+  }
+
+  /* Depending on the renderer, bindings are defined before or after this. */
+  if (wrapGlobals() || typeof global.render !== "function") {
+    return;
+  }
+  var render = global.render;
+  global.render = function (view, params, stream) {
+    if (wrapGlobals !== null) {
+      wrapGlobals();
+      wrapGlobals = null;
+    }
+    return render(view, params, stream);
+  };
+})(this);
+)DELIM";
+
+FrozenBindings::FrozenBindings(Object bindings)
+    : m_root(make_shared<const Value>(move(bindings))) {}
+
+Object FrozenBindings::globals() const {
+  Object globals;
+  Array names;
+  for (const auto &[key, value] : m_root->exactly<Object>()) {
+    globals.emplace(key, expose(m_root, value));
+    names.emplace_back(key);
+  }
+  globals.emplace(NAMES, Value(move(names)));
+  return globals;
+}
+
+Prototype FrozenBindings::prototype() {
+  Prototype prototype(Mapper::FROZEN);
+
+  prototype.addMethod(Method("__frozenKeys", [](void *p, const Array &) {
+    const auto &node = *static_cast<const Node *>(p);
+    Array keys;
+    keys.reserve(node.object->size());
+    for (const auto &item : *node.object) {
+      keys.emplace_back(item.first);
+    }
+    return Value(move(keys));
+  }));
+
+  prototype.addMethod(Method("__frozenHas", [](void *p, const Array &args) {
+    const auto &node = *static_cast<const Node *>(p);
+    if (args.empty() || !args.front().holds<String>()) {
+      return Value(false);
+    }
+    const auto &key = args.front().exactly<String>().get<string>();
+    return Value(node.object->find(key) != node.object->end());
+  }));
+
+  prototype.addMethod(Method("__frozenGet", [](void *p, const Array &args) {
+    const auto &node = *static_cast<const Node *>(p);
+    if (args.empty() || !args.front().holds<String>()) {
+      return Value(nullptr);
+    }
+    auto it = node.object->find(args.front().exactly<String>().get<string>());
+    if (it == node.object->end()) {
+      return Value(nullptr);
+    }
+    return expose(node.root, it->second);
+  }));
+
+  return prototype;
+}
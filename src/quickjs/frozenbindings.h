@@ -0,0 +1,45 @@
+/**
+ * Copyright 2021 Torsten Mehnert
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+#pragma once
+
+#include <complate/core/prototype.h>
+#include <complate/core/value.h>
+
+#include <memory>
+
+/**
+ * Bindings converted once and shared read-only by many renderers.
+ *
+ * The values stay in a single native tree. Each runtime gets proxies into
+ * that tree, and the views fetch a field from it when they read it for the
+ * first time. Only what a view actually reads is copied into its runtime.
+ */
+class FrozenBindings {
+public:
+  explicit FrozenBindings(complate::Object bindings);
+
+  /** Globals of a runtime, proxies for objects and plain scalars. */
+  [[nodiscard]] complate::Object globals() const;
+
+  /** Prototype used by the views to read from the shared tree. */
+  static complate::Prototype prototype();
+
+  /** Appended to the views, wraps the proxies into read-only objects. */
+  static const char *const JS;
+
+private:
+  std::shared_ptr<const complate::Value> m_root;
+};
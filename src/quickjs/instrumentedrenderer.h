@@ -0,0 +1,53 @@
+/**
+ * Copyright 2021 Torsten Mehnert
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+#pragma once
+
+#include <pybind11/pybind11.h>
+
+#include "pyinstrumentedrenderer.h"
+#include "renderbindings.h"
+
+static const char INSTRUMENTED_RENDERER_DOC_CLASS[] = R"DELIM(
+  Renderer which measures where the time of another renderer's renders goes.
+
+  Every render is split into seconds spent converting parameters, writing to
+  the stream, in calls of bindings and prototypes, and the remaining time
+  spent running JavaScript. Together with the bytes and the number of writes
+  and calls, these stats are passed as dict to the listener after each
+  render. stats() sums them up per view, including a cumulative histogram of
+  the render times, which can be exported to Prometheus.
+  Calls are measured for renderers created by the QuickJsRendererBuilder.
+  With the runtime hook, heap_bytes and heap_objects report the JavaScript
+  heap after the render, which stats() reports at its largest. Computing
+  them walks all objects of the heap.
+)DELIM";
+
+void registerInstrumentedRenderer(pybind11::module_ &m) {
+  namespace py = pybind11;
+  using namespace complate;
+
+  py::class_<PyInstrumentedRenderer, Renderer> cls(m, "InstrumentedRenderer");
+  cls.def(py::init<Renderer &, py::object>(),
+          "Construct an InstrumentedRenderer in front of renderer.",
+          py::keep_alive<1, 2>(), py::arg("renderer"),
+          py::arg("listener") = py::none());
+  defineRender(cls, &PyInstrumentedRenderer::renderDict);
+  cls.def("stats", &PyInstrumentedRenderer::stats,
+          "Get the summed up stats of all renders per view.");
+  cls.def("reset", &PyInstrumentedRenderer::reset,
+          "Drop the stats summed up so far.");
+  cls.doc() = INSTRUMENTED_RENDERER_DOC_CLASS;
+}
@@ -0,0 +1,103 @@
+/**
+ * Copyright 2021 Torsten Mehnert
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+#pragma once
+
+/**
+ * Appended to every views bundle built by the PyQuickJsRendererBuilder.
+ *
+ * When parameters were passed with lazy=True, it wraps the dicts exposed
+ * through the LazyDict prototype into JavaScript proxies. A field is fetched
+ * from Python when the view reads it for the first time and kept for the rest
+ * of the render.
+ */
+static const char LAZY_PARAMETERS_JS[] = R"DELIM(
+;(function (global) {
+  if (typeof global.render !== "function") {
+    return;
+  }
+
+  function isLazy(value) {
+    return value !== null && typeof value === "object" &&
+        typeof value.__lazyKeys === "function";
+  }
+
+  function unwrap(value) {
+    if (isLazy(value)) {
+      return lazy(value);
+    }
+    if (Array.isArray(value)) {
+      return value.map(unwrap);
+    }
+    return value;
+  }
+
+  function lazy(dict) {
+    var target = {};
+    var keys = null;
+    var known = Object.create(null);
+    function ownKeys() {
+      if (keys === null) {
+        keys = dict.__lazyKeys();
+      }
+      return keys;
+    }
+    function has(key) {
+      if (typeof key !== "string") {
+        return false;
+      }
+      if (!(key in known)) {
+        known[key] = dict.__lazyHas(key);
+      }
+      return known[key];
+    }
+    function load(key) {
+      if (!Object.prototype.hasOwnProperty.call(target, key)) {
+        target[key] = unwrap(dict.__lazyGet(key));
+      }
+      return target[key];
+    }
+    return new Proxy(target, {
+      get: function (t, key, receiver) {
+        return has(key) ? load(key) : Reflect.get(t, key, receiver);
+      },
+      has: function (t, key) {
+        return has(key) || key in t;
+      },
+      ownKeys: function () {
+        return ownKeys().slice();
+      },
+      getOwnPropertyDescriptor: function (t, key) {
+        if (!has(key)) {
+          return Reflect.getOwnPropertyDescriptor(t, key);
+        }
+        load(key);
+        return Reflect.getOwnPropertyDescriptor(t, key);
+      }
+    });
+  }
+
+  var render = global.render;
+  global.render = function (view, params, stream) {
+    if (params && params.__complatecppLazy === true) {
+      delete params.__complatecppLazy;
+      Object.keys(params).forEach(function (key) {
+        params[key] = unwrap(params[key]);
+      });
+    }
+    return render(view, params, stream);
+  };
+})(this);
+)DELIM";
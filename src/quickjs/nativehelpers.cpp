@@ -0,0 +1,272 @@
+/**
+ * Copyright 2021 Torsten Mehnert
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+#include "nativehelpers.h"
+
+#include <complate/core/function.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <stdexcept>
+
+using namespace std;
+using namespace complate;
+
+const char *const NativeHelpers::GLOBAL = "complatecpp";
+
+namespace {
+/* Replacement of each character escaped in text or attributes, or nullptr. */
+struct Escapes {
+  const char *text[256] = {};
+  const char *attribute[256] = {};
+
+  Escapes() {
+    text['&'] = attribute['&'] = "&amp;";
+    text['<'] = attribute['<'] = "&lt;";
+    text['>'] = attribute['>'] = "&gt;";
+    attribute['"'] = "&quot;";
+    attribute['\''] = "&#x27;";
+  }
+};
+
+const Escapes ESCAPES;
+
+double number(const Value &value) {
+  const auto &number = value.exactly<Number>();
+  if (number.holds<int32_t>()) {
+    return number.exactly<int32_t>();
+  } else if (number.holds<uint32_t>()) {
+    return number.exactly<uint32_t>();
+  } else if (number.holds<int64_t>()) {
+    return static_cast<double>(number.exactly<int64_t>());
+  }
+  return number.exactly<double>();
+}
+
+/** Argument at index, nullptr for a missing one, which reads as undefined. */
+const Value *arg(const Array &args, size_t index) {
+  return index < args.size() ? &args[index] : nullptr;
+}
+
+bool isNullish(const Value *value) {
+  return !value || value->holds<Null>() ||
+         !(value->holds<Bool>() || value->holds<Number>() ||
+           value->holds<String>() || value->holds<Array>() ||
+           value->holds<Object>() || value->holds<Function>() ||
+           value->holds<Proxy>());
+}
+
+/** Unlike isdigit(), independent of the locale. */
+bool isDigit(char c) { return '0' <= c && c <= '9'; }
+
+/** Like Number.prototype.toString(), the shortest digits reading back. */
+void appendNumber(string &out, double value) {
+  if (std::isnan(value)) {
+    out.append("NaN");
+    return;
+  }
+  if (value == 0) {
+    out.push_back('0');
+    return;
+  }
+  if (value < 0) {
+    out.push_back('-');
+    value = -value;
+  }
+  if (std::isinf(value)) {
+    out.append("Infinity");
+    return;
+  }
+
+  /* Both use the same decimal point of LC_NUMERIC, so reading back works. */
+  char buffer[32];
+  for (int precision = 0; precision <= 16; ++precision) {
+    snprintf(buffer, sizeof(buffer), "%.*e", precision, value);
+    if (strtod(buffer, nullptr) == value) {
+      break;
+    }
+  }
+  /* Split d.ddde±x into its digits and the position of the point. */
+  string digits;
+  const char *c = buffer;
+  for (; *c != 'e'; ++c) {
+    if (isDigit(*c)) {
+      digits.push_back(*c);
+    }
+  }
+  int point = atoi(c + 1) + 1;
+  auto count = static_cast<int>(digits.size());
+
+  if (count <= point && point <= 21) {
+    out.append(digits);
+    out.append(point - count, '0');
+  } else if (0 < point && point <= 21) {
+    out.append(digits, 0, point);
+    out.push_back('.');
+    out.append(digits, point, string::npos);
+  } else if (-6 < point && point <= 0) {
+    out.append("0.");
+    out.append(-point, '0');
+    out.append(digits);
+  } else {
+    out.push_back(digits[0]);
+    if (count > 1) {
+      out.push_back('.');
+      out.append(digits, 1, string::npos);
+    }
+    out.append(point > 0 ? "e+" : "e-");
+    out.append(to_string(abs(point - 1)));
+  }
+}
+
+void append(string &out, const Value *value);
+
+/** Like Array.prototype.join(), null and undefined items are empty. */
+void appendJoined(string &out, const Array &items, const string &separator) {
+  bool first = true;
+  for (const auto &item : items) {
+    if (!first) {
+      out.append(separator);
+    }
+    first = false;
+    if (!isNullish(&item)) {
+      append(out, &item);
+    }
+  }
+}
+
+/** Like String(value). */
+void append(string &out, const Value *value) {
+  if (!value) {
+    out.append("undefined");
+  } else if (value->holds<String>()) {
+    out.append(value->exactly<String>().get<string>());
+  } else if (value->holds<Number>()) {
+    appendNumber(out, number(*value));
+  } else if (value->holds<Bool>()) {
+    out.append(value->exactly<Bool>() ? "true" : "false");
+  } else if (value->holds<Null>()) {
+    out.append("null");
+  } else if (value->holds<Array>()) {
+    appendJoined(out, value->exactly<Array>(), ",");
+  } else if (value->holds<Object>() || value->holds<Proxy>()) {
+    out.append("[object Object]");
+  } else if (value->holds<Function>()) {
+    out.append("function () { [native code] }");
+  } else {
+    out.append("undefined");
+  }
+}
+
+string toString(const Value *value) {
+  string out;
+  append(out, value);
+  return out;
+}
+
+string stringArg(const Array &args, size_t index, const string &fallback) {
+  const auto *value = arg(args, index);
+  return isNullish(value) ? fallback : toString(value);
+}
+}  // namespace
+
+Object NativeHelpers::create() {
+  return Object{
+      {"escapeHtml", Value(Function([](const Array &args) {
+         const auto *attribute = arg(args, 1);
+         return Value(escapeHtml(
+             toString(arg(args, 0)),
+             attribute && attribute->holds<Bool>() &&
+                 attribute->exactly<Bool>()));
+       }))},
+      {"join", Value(Function([](const Array &args) {
+         auto separator = stringArg(args, 1, ",");
+         string out;
+         const auto *items = arg(args, 0);
+         if (items && items->holds<Array>()) {
+           appendJoined(out, items->exactly<Array>(), separator);
+         }
+         return Value(move(out));
+       }))},
+      {"formatNumber", Value(Function([](const Array &args) {
+         const auto *value = arg(args, 0);
+         if (!value || !value->holds<Number>()) {
+           throw invalid_argument("formatNumber() expects a number, got " +
+                                  toString(value));
+         }
+         const auto *decimals = arg(args, 1);
+         return Value(formatNumber(
+             number(*value),
+             decimals && decimals->holds<Number>()
+                 ? static_cast<int>(number(*decimals))
+                 : 0,
+             stringArg(args, 2, ","), stringArg(args, 3, ".")));
+       }))}};
+}
+
+string NativeHelpers::escapeHtml(const string &str, bool attribute) {
+  const auto &table = attribute ? ESCAPES.attribute : ESCAPES.text;
+  string out;
+  out.reserve(str.size() + str.size() / 8);
+  size_t start = 0;
+  for (size_t i = 0; i < str.size(); ++i) {
+    const char *escape = table[static_cast<unsigned char>(str[i])];
+    if (escape) {
+      out.append(str, start, i - start);
+      out.append(escape);
+      start = i + 1;
+    }
+  }
+  out.append(str, start, string::npos);
+  return out;
+}
+
+string NativeHelpers::formatNumber(double number, int decimals,
+                                   const string &thousands,
+                                   const string &point) {
+  if (!std::isfinite(number)) {
+    return std::isnan(number) ? "NaN" : (number < 0 ? "-Infinity" : "Infinity");
+  }
+  decimals = max(0, min(decimals, 20));
+  char buffer[400];
+  snprintf(buffer, sizeof(buffer), "%.*f", decimals, std::fabs(number));
+  /* The decimal point is the one of LC_NUMERIC, anything but digits. */
+  string digits(buffer);
+  auto dot = digits.find_first_not_of("0123456789");
+  auto integer = digits.substr(0, dot);
+  string fraction;
+  if (dot != string::npos) {
+    fraction = digits.substr(digits.find_first_of("0123456789", dot));
+  }
+
+  string out;
+  auto zero = (integer + fraction).find_first_not_of('0') == string::npos;
+  if (number < 0 && !zero) {
+    out.push_back('-');
+  }
+  for (size_t i = 0; i < integer.size(); ++i) {
+    if (i > 0 && (integer.size() - i) % 3 == 0) {
+      out.append(thousands);
+    }
+    out.push_back(integer[i]);
+  }
+  if (dot != string::npos) {
+    out.append(point);
+    out.append(fraction);
+  }
+  return out;
+}
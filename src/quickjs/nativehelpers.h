@@ -0,0 +1,44 @@
+/**
+ * Copyright 2021 Torsten Mehnert
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+#pragma once
+
+#include <complate/core/value.h>
+
+#include <string>
+
+/**
+ * Native helper functions for views, exposed as a global object.
+ *
+ * They don't call into Python, so views rendering on a pool use them without
+ * acquiring the GIL. Arguments are converted to strings like String() and
+ * Array.prototype.join() do in JavaScript.
+ */
+class NativeHelpers {
+public:
+  NativeHelpers() = delete;
+
+  /** Name of the global object holding the helpers. */
+  static const char *const GLOBAL;
+
+  static complate::Object create();
+
+  /** Escape &, < and >, plus " and ' when used in an attribute. */
+  static std::string escapeHtml(const std::string &str, bool attribute);
+  /** Format a number with a fixed number of decimals and grouped thousands. */
+  static std::string formatNumber(double number, int decimals,
+                                  const std::string &thousands,
+                                  const std::string &point);
+};
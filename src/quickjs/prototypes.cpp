@@ -17,12 +17,121 @@
 
 #include <pybind11/functional.h>
 
+#include "deadline.h"
+#include "gil.h"
 #include "mapper.h"
+#include "renderstats.h"
 
 using namespace std;
 using namespace complate;
 namespace py = pybind11;
 
+namespace {
+/**
+ * Attribute of a type, resolved once when the prototype is created.
+ *
+ * Data descriptors (slots, properties) found on the type are called directly
+ * for instances of exactly that type, they take precedence over the instance
+ * dict. Everything else, and instances of other types, is looked up by the
+ * interned name.
+ */
+struct Attribute {
+  py::object type;
+  py::object name;
+  py::object descriptor;
+};
+
+/** Find an attribute in the dicts of the type and its bases, like Python. */
+py::object lookup(const py::handle &type, const py::object &name) {
+  for (auto base : type.attr("__mro__")) {
+    auto dict = base.attr("__dict__");
+    if (dict.contains(name)) {
+      return dict[name];
+    }
+  }
+  return py::object();
+}
+
+shared_ptr<Attribute> resolve(const py::handle &type, const string &name) {
+  auto attribute = Gil::make_shared<Attribute>();
+  attribute->type = py::reinterpret_borrow<py::object>(type);
+  attribute->name = py::reinterpret_steal<py::object>(
+      PyUnicode_InternFromString(name.c_str()));
+
+  auto found = lookup(type, attribute->name);
+  if (found && Py_TYPE(found.ptr())->tp_descr_get &&
+      Py_TYPE(found.ptr())->tp_descr_set) {
+    attribute->descriptor = found;
+  }
+  return attribute;
+}
+
+bool exact(const Attribute &attribute, const py::object &obj) {
+  return Py_TYPE(obj.ptr()) ==
+         reinterpret_cast<PyTypeObject *>(attribute.type.ptr());
+}
+
+/** Methods are called without creating a bound method, where supported. */
+py::object call(const Attribute &attribute, const py::object &obj,
+                const Array &args) {
+#if PY_VERSION_HEX >= 0x03090000
+  auto tup = Mapper::args_to_tuple(args, obj);
+  auto result = PyObject_VectorcallMethod(
+      attribute.name.ptr(), PySequence_Fast_ITEMS(tup.ptr()),
+      static_cast<size_t>(PyTuple_GET_SIZE(tup.ptr())), nullptr);
+  if (!result) {
+    throw py::error_already_set();
+  }
+  return py::reinterpret_steal<py::object>(result);
+#else
+  auto tup = Mapper::args_to_tuple(args);
+  return obj.attr(attribute.name)(*tup);
+#endif
+}
+
+py::object get(const Attribute &attribute, const py::object &obj) {
+  if (attribute.descriptor && exact(attribute, obj)) {
+    auto descr = attribute.descriptor.ptr();
+    auto result = Py_TYPE(descr)->tp_descr_get(descr, obj.ptr(),
+                                               attribute.type.ptr());
+    if (!result) {
+      throw py::error_already_set();
+    }
+    return py::reinterpret_steal<py::object>(result);
+  }
+  return obj.attr(attribute.name);
+}
+
+void set(const Attribute &attribute, const py::object &obj,
+         const py::object &value) {
+  if (attribute.descriptor && exact(attribute, obj)) {
+    auto descr = attribute.descriptor.ptr();
+    if (Py_TYPE(descr)->tp_descr_set(descr, obj.ptr(), value.ptr()) < 0) {
+      throw py::error_already_set();
+    }
+    return;
+  }
+  obj.attr(attribute.name) = value;
+}
+
+/** Value of a lazy dict for a key read by a view, or a null handle. */
+py::handle find(const py::dict &dict, const py::object &key) {
+  if (auto value = PyDict_GetItemWithError(dict.ptr(), key.ptr())) {
+    return value;
+  }
+  if (PyErr_Occurred()) {
+    throw py::error_already_set();
+  }
+  /* Keys which are no strings, were exposed by their string value. */
+  for (auto item : dict) {
+    if (!PyUnicode_Check(item.first.ptr()) && py::str(item.first).equal(key)) {
+      return item.second;
+    }
+  }
+  return py::handle();
+}
+}  // namespace
+
 vector<Prototype> Prototypes::create_prototypes(const py::list &types) {
   vector<Prototype> prototypes;
   for (auto type : types) {
@@ -36,24 +145,36 @@ vector<Prototype> Prototypes::create_prototypes(const py::list &types) {
         continue;
       }
 
+      auto attribute = resolve(type, name);
       if (callable(type.attr(name.c_str())).cast<bool>()) {
-        Method method(name, [name](void *p, const Array &args) {
+        Method method(name, [attribute](void *p, const Array &args) {
+          Deadline::check();
+          RenderStats::Callback timing;
+          Mapper::Call fromView;
+          py::gil_scoped_acquire acquire;
           auto obj = static_cast<py::object *>(p);
-          auto tup = Mapper::args_to_tuple(args);
-          return obj->attr(name.c_str())(*tup).cast<Value>();
+          return Mapper::python_to_value(call(*attribute, *obj, args));
         });
 
         prototype.addMethod(method);
       } else {
         Property prop(
             name,
-            [name](void *p) {
+            [attribute](void *p) {
+              Deadline::check();
+              RenderStats::Callback timing;
+              Mapper::Call fromView;
+              py::gil_scoped_acquire acquire;
               auto obj = static_cast<py::object *>(p);
-              return obj->attr(name.c_str()).cast<Value>();
+              return Mapper::python_to_value(get(*attribute, *obj));
             },
-            [name](void *p, const Value &value) {
+            [attribute](void *p, const Value &value) {
+              Deadline::check();
+              RenderStats::Callback timing;
+              Mapper::Call fromView;
+              py::gil_scoped_acquire acquire;
               auto obj = static_cast<py::object *>(p);
-              obj->attr(name.c_str()) = Mapper::value_to_python(value);
+              set(*attribute, *obj, Mapper::value_to_python(value));
             });
         prototype.addProperty(prop);
       }
@@ -63,3 +184,40 @@ vector<Prototype> Prototypes::create_prototypes(const py::list &types) {
 
   return prototypes;
 }
+
+Prototype Prototypes::create_lazy_prototype() {
+  Prototype prototype(Mapper::LAZY_DICT);
+
+  prototype.addMethod(Method("__lazyKeys", [](void *p, const Array &) {
+    Deadline::check();
+    py::gil_scoped_acquire acquire;
+    auto dict = static_cast<py::object *>(p)->cast<py::dict>();
+    Array keys;
+    keys.reserve(dict.size());
+    for (auto item : dict) {
+      keys.emplace_back(py::str(item.first).cast<string>());
+    }
+    return Value(move(keys));
+  }));
+
+  prototype.addMethod(Method("__lazyHas", [](void *p, const Array &args) {
+    Deadline::check();
+    py::gil_scoped_acquire acquire;
+    auto dict = static_cast<py::object *>(p)->cast<py::dict>();
+    auto key = Mapper::value_to_python(args.at(0));
+    return Value(static_cast<bool>(find(dict, key)));
+  }));
+
+  prototype.addMethod(Method("__lazyGet", [](void *p, const Array &args) {
+    Deadline::check();
+    py::gil_scoped_acquire acquire;
+    auto dict = static_cast<py::object *>(p)->cast<py::dict>();
+    auto key = Mapper::value_to_python(args.at(0));
+    if (auto value = find(dict, key)) {
+      return Mapper::python_to_value(value, true);
+    }
+    return Value(nullptr);
+  }));
+
+  return prototype;
+}
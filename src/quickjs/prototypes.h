@@ -24,4 +24,7 @@ public:
   Prototypes() = delete;
 
   static std::vector<complate::Prototype> create_prototypes(const pybind11::list &types);
+
+  /** Prototype used to access dicts passed with lazy=True. */
+  static complate::Prototype create_lazy_prototype();
 };
@@ -0,0 +1,194 @@
+/**
+ * Copyright 2021 Torsten Mehnert
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+#include "pyinstrumentedrenderer.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "jsonwriter.h"
+#include "mapper.h"
+#include "renderbindings.h"
+
+using namespace std;
+using namespace complate;
+namespace py = pybind11;
+
+using Clock = RenderStats::Clock;
+
+namespace {
+/** Stream which adds the time spent writing to the stats of a render. */
+class CountingStream : public Stream {
+public:
+  CountingStream(Stream &stream, RenderStats &stats)
+      : m_stream(stream), m_stats(stats) {}
+
+  void write(const char *str, int len) override {
+    auto start = Clock::now();
+    m_stream.write(str, len);
+    count(start, len);
+  }
+
+  void writeln(const char *str, int len) override {
+    auto start = Clock::now();
+    m_stream.writeln(str, len);
+    count(start, len + 1);
+  }
+
+  void flush() override {
+    auto start = Clock::now();
+    m_stream.flush();
+    m_stats.stream += Clock::now() - start;
+  }
+
+private:
+  void count(Clock::time_point start, int len) {
+    m_stats.stream += Clock::now() - start;
+    m_stats.bytes += len;
+    ++m_stats.writes;
+  }
+
+  Stream &m_stream;
+  RenderStats &m_stats;
+};
+
+double seconds(Clock::duration duration) {
+  return chrono::duration<double>(duration).count();
+}
+
+void fill(py::dict &dict, const RenderStats &stats) {
+  dict["conversion"] = seconds(stats.conversion);
+  dict["javascript"] = seconds(stats.javascript);
+  dict["stream"] = seconds(stats.stream);
+  dict["callbacks"] = seconds(stats.callbacks);
+  dict["bytes"] = stats.bytes;
+  dict["writes"] = stats.writes;
+  dict["calls"] = stats.calls;
+  dict["heap_bytes"] = stats.heapBytes;
+  dict["heap_objects"] = stats.heapObjects;
+}
+}  // namespace
+
+PyInstrumentedRenderer::PyInstrumentedRenderer(Renderer &renderer,
+                                               py::object listener)
+    : m_renderer(renderer), m_listener(move(listener)) {}
+
+void PyInstrumentedRenderer::render(const string &view,
+                                    const Object &parameters,
+                                    Stream &stream) {
+  RenderStats stats;
+  measure(view, stats, stream, [&](Stream &counting) {
+    m_renderer.render(view, parameters, counting);
+  });
+}
+
+void PyInstrumentedRenderer::render(const string &view,
+                                    const string &parameters,
+                                    Stream &stream) {
+  RenderStats stats;
+  measure(view, stats, stream, [&](Stream &counting) {
+    m_renderer.render(view, parameters, counting);
+  });
+}
+
+void PyInstrumentedRenderer::renderDict(Renderer &renderer,
+                                        const string &view,
+                                        const py::dict &parameters,
+                                        Stream &stream, bool lazy,
+                                        bool asJson) {
+  checkDictOptions(lazy, asJson);
+  auto &self = static_cast<PyInstrumentedRenderer &>(renderer);
+  RenderStats stats;
+  self.measure(view, stats, stream, [&](Stream &counting) {
+    auto start = Clock::now();
+    if (asJson) {
+      JsonBuffer json(parameters);
+      stats.conversion = Clock::now() - start;
+      self.m_renderer.render(view, json.str(), counting);
+    } else {
+      auto object = Mapper::python_to_object(parameters, lazy);
+      stats.conversion = Clock::now() - start;
+      self.m_renderer.render(view, object, counting);
+    }
+  });
+}
+
+py::dict PyInstrumentedRenderer::stats() {
+  lock_guard<mutex> lock(m_mutex);
+  py::dict views;
+  for (const auto &[view, summary] : m_views) {
+    py::list buckets;
+    size_t cumulative = 0;
+    for (size_t i = 0; i < BUCKETS.size(); ++i) {
+      cumulative += summary.buckets[i];
+      buckets.append(py::make_tuple(BUCKETS[i], cumulative));
+    }
+    buckets.append(py::make_tuple(py::float_(INFINITY), summary.count));
+
+    py::dict dict;
+    dict["count"] = summary.count;
+    dict["sum"] = seconds(summary.total);
+    dict["buckets"] = buckets;
+    fill(dict, summary.sum);
+    views[py::str(view)] = dict;
+  }
+  return views;
+}
+
+void PyInstrumentedRenderer::reset() {
+  lock_guard<mutex> lock(m_mutex);
+  m_views.clear();
+}
+
+template <typename Render>
+void PyInstrumentedRenderer::measure(const string &view, RenderStats &stats,
+                                     Stream &stream, const Render &render) {
+  CountingStream counting(stream, stats);
+  auto start = Clock::now();
+  {
+    RenderStats::Scope scope(&stats);
+    render(counting);
+  }
+  auto total = Clock::now() - start;
+  stats.javascript = max(
+      total - stats.conversion - stats.stream - stats.callbacks,
+      Clock::duration::zero());
+  record(view, stats, total);
+}
+
+void PyInstrumentedRenderer::record(const string &view,
+                                    const RenderStats &stats,
+                                    Clock::duration total) {
+  {
+    lock_guard<mutex> lock(m_mutex);
+    auto &summary = m_views[view];
+    ++summary.count;
+    auto bucket = lower_bound(BUCKETS.begin(), BUCKETS.end(), seconds(total));
+    if (bucket != BUCKETS.end()) {
+      ++summary.buckets[bucket - BUCKETS.begin()];
+    }
+    summary.total += total;
+    summary.sum.add(stats);
+  }
+
+  py::gil_scoped_acquire acquire;
+  if (!m_listener.is_none()) {
+    py::dict dict;
+    dict["view"] = view;
+    dict["total"] = seconds(total);
+    fill(dict, stats);
+    m_listener(dict);
+  }
+}
@@ -0,0 +1,82 @@
+/**
+ * Copyright 2021 Torsten Mehnert
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+#pragma once
+
+#include <complate/core/renderer.h>
+#include <pybind11/pybind11.h>
+
+#include <array>
+#include <map>
+#include <mutex>
+#include <string>
+
+#include "renderstats.h"
+
+/**
+ * Renderer which measures the renders of another renderer.
+ *
+ * Each render is split into the time spent converting parameters, writing to
+ * the stream, calling back into Python and the remaining time spent in the
+ * JavaScript engine. The stats of every render are passed to a listener and
+ * summed up per view.
+ */
+class PyInstrumentedRenderer : public complate::Renderer {
+public:
+  /** Upper bounds in seconds of the render time histogram buckets. */
+  static constexpr std::array<double, 16> BUCKETS = {
+      0.0001, 0.00025, 0.0005, 0.001, 0.0025, 0.005, 0.01, 0.025,
+      0.05,   0.1,     0.25,   0.5,   1.0,    2.5,   5.0,  10.0};
+
+  PyInstrumentedRenderer(complate::Renderer &renderer,
+                         pybind11::object listener);
+
+  void render(const std::string &view, const complate::Object &parameters,
+              complate::Stream &stream) override;
+  void render(const std::string &view, const std::string &parameters,
+              complate::Stream &stream) override;
+
+  /**
+   * Render with dict parameters, including the time to convert them.
+   *
+   * Replaces renderDict() in the render methods of an instrumented renderer.
+   */
+  static void renderDict(complate::Renderer &renderer,
+                         const std::string &view,
+                         const pybind11::dict &parameters,
+                         complate::Stream &stream, bool lazy, bool asJson);
+
+  [[nodiscard]] pybind11::dict stats();
+  void reset();
+
+private:
+  struct Summary {
+    std::size_t count = 0;
+    std::array<std::size_t, BUCKETS.size()> buckets{};
+    RenderStats::Clock::duration total{0};
+    RenderStats sum;
+  };
+
+  template <typename Render>
+  void measure(const std::string &view, RenderStats &stats,
+               complate::Stream &stream, const Render &render);
+  void record(const std::string &view, const RenderStats &stats,
+              RenderStats::Clock::duration total);
+
+  complate::Renderer &m_renderer;
+  pybind11::object m_listener;
+  std::mutex m_mutex;
+  std::map<std::string, Summary> m_views;
+};
@@ -0,0 +1,228 @@
+/**
+ * Copyright 2021 Torsten Mehnert
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+#include "pyquickjsrendererbuilder.h"
+
+#include <stdexcept>
+
+#include "deadlinerenderer.h"
+#include "lazyparameters.h"
+#include "nativehelpers.h"
+#include "prototypes.h"
+#include "recyclingrenderer.h"
+
+using namespace std;
+using namespace complate;
+
+PyQuickJsRendererBuilder::PyQuickJsRendererBuilder()
+    : m_sourceCreator([]() { return string(); }),
+      m_bindingsCreator([]() { return Object(); }) {}
+
+PyQuickJsRendererBuilder &PyQuickJsRendererBuilder::source(string source) {
+  auto shared = make_shared<const string>(move(source));
+  m_sourceCreator = [shared]() { return *shared; };
+  return *this;
+}
+
+PyQuickJsRendererBuilder &PyQuickJsRendererBuilder::source(
+    SourceCreator sourceCreator) {
+  m_sourceCreator = move(sourceCreator);
+  return *this;
+}
+
+PyQuickJsRendererBuilder &PyQuickJsRendererBuilder::bindings(Object bindings) {
+  auto shared = make_shared<const Object>(move(bindings));
+  m_bindingsCreator = [shared]() { return *shared; };
+  return *this;
+}
+
+PyQuickJsRendererBuilder &PyQuickJsRendererBuilder::bindings(
+    BindingsCreator bindingsCreator) {
+  m_bindingsCreator = move(bindingsCreator);
+  return *this;
+}
+
+PyQuickJsRendererBuilder &PyQuickJsRendererBuilder::frozenBindings(
+    Object bindings) {
+  m_frozenBindings = make_shared<const FrozenBindings>(move(bindings));
+  return *this;
+}
+
+PyQuickJsRendererBuilder &PyQuickJsRendererBuilder::prototypes(
+    vector<Prototype> prototypes) {
+  m_prototypes = move(prototypes);
+  return *this;
+}
+
+PyQuickJsRendererBuilder &PyQuickJsRendererBuilder::recycleAfter(
+    size_t renders, size_t heapBytes) {
+  if (heapBytes > 0) {
+    RuntimeRenderer::require("Recycling by heap size");
+  }
+  m_recycleAfter = renders;
+  m_recycleAbove = heapBytes;
+  return *this;
+}
+
+PyQuickJsRendererBuilder &PyQuickJsRendererBuilder::memoryLimit(size_t bytes) {
+  RuntimeRenderer::require("A memory limit");
+  m_runtimeOptions.memoryLimit = bytes;
+  return *this;
+}
+
+PyQuickJsRendererBuilder &PyQuickJsRendererBuilder::gcThreshold(size_t bytes) {
+  RuntimeRenderer::require("A GC threshold");
+  m_runtimeOptions.gcThreshold = bytes;
+  return *this;
+}
+
+PyQuickJsRendererBuilder &PyQuickJsRendererBuilder::maxStackSize(
+    size_t bytes) {
+  RuntimeRenderer::require("A max stack size");
+  m_runtimeOptions.maxStackSize = bytes;
+  return *this;
+}
+
+PyQuickJsRendererBuilder &PyQuickJsRendererBuilder::collectWhenIdle(
+    bool enabled) {
+  if (enabled) {
+    RuntimeRenderer::require("Collecting garbage when idle");
+  }
+  m_collectWhenIdle = enabled;
+  return *this;
+}
+
+PyQuickJsRendererBuilder &PyQuickJsRendererBuilder::bytecodeCache(
+    string directory) {
+  RuntimeRenderer::require("A bytecode cache");
+  m_bytecodeCache = make_shared<BytecodeCache>(move(directory));
+  return *this;
+}
+
+string PyQuickJsRendererBuilder::source() const { return m_sourceCreator(); }
+
+PyQuickJsRendererBuilder &PyQuickJsRendererBuilder::timeout(double timeoutMs) {
+  m_timeoutMs = timeoutMs;
+  return *this;
+}
+
+RendererPool::Options PyQuickJsRendererBuilder::poolOptions() const {
+  RendererPool::Options options;
+  options.recycleAfter = m_recycleAfter;
+  options.recycleAbove = m_recycleAbove;
+  options.collectWhenIdle = m_collectWhenIdle;
+  options.timeoutMs = m_timeoutMs;
+  return options;
+}
+
+PyQuickJsRendererBuilder &PyQuickJsRendererBuilder::nativeHelpers(
+    bool enabled) {
+  m_nativeHelpers = enabled;
+  return *this;
+}
+
+PyQuickJsRendererBuilder &PyQuickJsRendererBuilder::staticViews(
+    map<string, Object> views) {
+  m_staticViews = move(views);
+  m_staticOutputs.reset();
+  return *this;
+}
+
+PyQuickJsRendererBuilder PyQuickJsRendererBuilder::resolved() const {
+  PyQuickJsRendererBuilder builder(*this);
+  builder.source(m_sourceCreator());
+  builder.bindings(m_bindingsCreator());
+  if (!m_staticViews.empty() && !m_staticOutputs) {
+    auto renderer = builder.createQuickJs();
+    builder.m_staticOutputs = make_shared<const StaticViewsRenderer::Outputs>(
+        StaticViewsRenderer::prerender(*renderer, m_staticViews));
+  }
+  return builder;
+}
+
+unique_ptr<Renderer> PyQuickJsRendererBuilder::unique() const {
+  if (m_timeoutMs > 0) {
+    auto resolved = this->resolved();
+    resolved.m_timeoutMs = 0;
+    return make_unique<DeadlineRenderer>(
+        [resolved]() { return resolved.unique(); }, m_timeoutMs);
+  }
+  if (m_recycleAfter > 0 || m_recycleAbove > 0) {
+    return make_unique<RecyclingRenderer>(resolved().creator(),
+                                          m_recycleAfter, m_recycleAbove);
+  }
+  if (!m_staticViews.empty()) {
+    return resolved().create();
+  }
+  return create();
+}
+
+RendererPool::Creator PyQuickJsRendererBuilder::creator() const {
+  return [builder = *this]() { return builder.create(); };
+}
+
+unique_ptr<Renderer> PyQuickJsRendererBuilder::create() const {
+  return RuntimeRenderer::create(
+      [this]() -> unique_ptr<Renderer> {
+        if (m_staticOutputs) {
+          return make_unique<StaticViewsRenderer>(createQuickJs(),
+                                                  m_staticOutputs);
+        }
+        return createQuickJs();
+      },
+      m_runtimeOptions);
+}
+
+unique_ptr<Renderer> PyQuickJsRendererBuilder::createQuickJs() const {
+  auto prototypes = m_prototypes;
+  prototypes.push_back(Prototypes::create_lazy_prototype());
+
+  auto source = m_sourceCreator() + LAZY_PARAMETERS_JS;
+  auto bindings = m_bindingsCreator();
+  if (m_frozenBindings) {
+    prototypes.push_back(FrozenBindings::prototype());
+    source += FrozenBindings::JS;
+    for (auto &[key, value] : m_frozenBindings->globals()) {
+      bindings.insert_or_assign(key, move(value));
+    }
+  }
+  if (m_nativeHelpers) {
+    bindings.insert_or_assign(NativeHelpers::GLOBAL,
+                              Value(NativeHelpers::create()));
+  }
+  if (m_staticOutputs) {
+    bindings.insert_or_assign(
+        StaticViewsRenderer::GLOBAL,
+        Value(StaticViewsRenderer::fragments(*m_staticOutputs)));
+  }
+
+  QuickJsRendererBuilder builder;
+  builder.bindings(move(bindings));
+  builder.prototypes(prototypes);
+  if (!m_bytecodeCache) {
+    builder.source(move(source));
+    return builder.unique();
+  }
+
+  /* The cache recognizes the evaluation of the views by their source. */
+  builder.source(source);
+  BytecodeCache::Use use(*m_bytecodeCache, source);
+  auto renderer = builder.unique();
+  if (!use.evaluated()) {
+    throw logic_error("complate didn't evaluate the views as a whole, so "
+                      "they can't be loaded from the bytecode cache");
+  }
+  return renderer;
+}
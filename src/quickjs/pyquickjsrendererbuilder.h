@@ -0,0 +1,100 @@
+/**
+ * Copyright 2021 Torsten Mehnert
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+#pragma once
+
+#include <complate/quickjs/quickjsrendererbuilder.h>
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "bytecodecache.h"
+#include "frozenbindings.h"
+#include "rendererpool.h"
+#include "runtimerenderer.h"
+#include "staticviewsrenderer.h"
+
+/**
+ * Builder for QuickJsRenderer instances used by the Python module.
+ *
+ * It keeps everything passed to it, so that it is able to resolve the
+ * creators once and build many renderers from the same source, bindings and
+ * prototypes.
+ */
+class PyQuickJsRendererBuilder {
+public:
+  using SourceCreator = complate::QuickJsRendererBuilder::SourceCreator;
+  using BindingsCreator = complate::QuickJsRendererBuilder::BindingsCreator;
+
+  PyQuickJsRendererBuilder();
+
+  PyQuickJsRendererBuilder &source(std::string source);
+  PyQuickJsRendererBuilder &source(SourceCreator sourceCreator);
+  PyQuickJsRendererBuilder &bindings(complate::Object bindings);
+  PyQuickJsRendererBuilder &bindings(BindingsCreator bindingsCreator);
+  /** Bindings converted once and shared by all renderers built from here. */
+  PyQuickJsRendererBuilder &frozenBindings(complate::Object bindings);
+  PyQuickJsRendererBuilder &prototypes(
+      std::vector<complate::Prototype> prototypes);
+  PyQuickJsRendererBuilder &recycleAfter(std::size_t renders,
+                                         std::size_t heapBytes = 0);
+  PyQuickJsRendererBuilder &memoryLimit(std::size_t bytes);
+  PyQuickJsRendererBuilder &gcThreshold(std::size_t bytes);
+  PyQuickJsRendererBuilder &maxStackSize(std::size_t bytes);
+  PyQuickJsRendererBuilder &collectWhenIdle(bool enabled);
+  /** Compile the views once, keeping the bytecode in the directory if any. */
+  PyQuickJsRendererBuilder &bytecodeCache(std::string directory);
+  PyQuickJsRendererBuilder &nativeHelpers(bool enabled);
+  PyQuickJsRendererBuilder &timeout(double timeoutMs);
+  PyQuickJsRendererBuilder &staticViews(
+      std::map<std::string, complate::Object> views);
+
+  /** Get the source by calling the source creator. */
+  [[nodiscard]] std::string source() const;
+
+  /** How the workers of a pool replace and clean up their renderers. */
+  [[nodiscard]] RendererPool::Options poolOptions() const;
+
+  /**
+   * Call the creators once, renderers built afterwards share the results.
+   *
+   * Static views are rendered here as well, so their output is shared too.
+   */
+  [[nodiscard]] PyQuickJsRendererBuilder resolved() const;
+
+  [[nodiscard]] std::unique_ptr<complate::Renderer> unique() const;
+  /** Creates renderers for a pool, which recycles them on its own. */
+  [[nodiscard]] RendererPool::Creator creator() const;
+
+private:
+  [[nodiscard]] std::unique_ptr<complate::Renderer> create() const;
+  [[nodiscard]] std::unique_ptr<complate::Renderer> createQuickJs() const;
+
+  SourceCreator m_sourceCreator;
+  BindingsCreator m_bindingsCreator;
+  std::shared_ptr<const FrozenBindings> m_frozenBindings;
+  std::vector<complate::Prototype> m_prototypes;
+  std::size_t m_recycleAfter = 0;
+  std::size_t m_recycleAbove = 0;
+  RuntimeOptions m_runtimeOptions;
+  std::shared_ptr<BytecodeCache> m_bytecodeCache;
+  bool m_collectWhenIdle = false;
+  bool m_nativeHelpers = false;
+  double m_timeoutMs = 0;
+  std::map<std::string, complate::Object> m_staticViews;
+  std::shared_ptr<const StaticViewsRenderer::Outputs> m_staticOutputs;
+};
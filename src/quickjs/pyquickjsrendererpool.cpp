@@ -0,0 +1,215 @@
+/**
+ * Copyright 2021 Torsten Mehnert
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+#include "pyquickjsrendererpool.h"
+
+#include <pybind11/pybind11.h>
+
+#include <functional>
+#include <set>
+
+using namespace std;
+namespace py = pybind11;
+
+namespace {
+size_t hashOf(const string &source) { return hash<string>()(source); }
+
+/** Report a source, which couldn't be read or reloaded by the watcher. */
+void warn(const string &reason) {
+  py::gil_scoped_acquire acquire;
+  auto message = "The views couldn't be reloaded: " + reason;
+  if (PyErr_WarnEx(PyExc_RuntimeWarning, message.c_str(), 1) < 0) {
+    PyErr_WriteUnraisable(nullptr);
+  }
+}
+
+/**
+ * Pools alive in this process.
+ *
+ * Pools are neither added nor removed while the process is being forked, so
+ * the set may be read without the mutex meanwhile. Leaked, to stay valid for
+ * pools destroyed on exit.
+ */
+struct Registry {
+  mutex guard;
+  condition_variable forked;
+  set<PyQuickJsRendererPool *> pools;
+  bool forking = false;
+};
+
+Registry &registry() {
+  static auto instance = new Registry();
+  return *instance;
+}
+
+void add(PyQuickJsRendererPool *pool) {
+  auto &r = registry();
+  unique_lock<mutex> lock(r.guard);
+  r.forked.wait(lock, [&r] { return !r.forking; });
+  r.pools.insert(pool);
+}
+
+void remove(PyQuickJsRendererPool *pool) {
+  auto &r = registry();
+  unique_lock<mutex> lock(r.guard);
+  r.forked.wait(lock, [&r] { return !r.forking; });
+  r.pools.erase(pool);
+}
+}  // namespace
+
+PyQuickJsRendererPool::PyQuickJsRendererPool(
+    const PyQuickJsRendererBuilder &builder, size_t size)
+    : PyQuickJsRendererPool(builder, builder.resolved(), size) {}
+
+PyQuickJsRendererPool::PyQuickJsRendererPool(
+    const PyQuickJsRendererBuilder &builder,
+    const PyQuickJsRendererBuilder &resolved, size_t size)
+    : RendererPool(resolved.creator(), size, builder.poolOptions()),
+      m_builder(builder),
+      m_hash(hashOf(resolved.source())) {
+  py::gil_scoped_release release;
+  add(this);
+}
+
+PyQuickJsRendererPool::~PyQuickJsRendererPool() {
+  py::gil_scoped_release release;
+  remove(this);
+  unwatch();
+}
+
+void PyQuickJsRendererPool::reload() {
+  lock_guard<mutex> lock(m_reloadMutex);
+  auto resolved = m_builder.resolved();
+  /* Fails for a broken source, before any renderer has been replaced. */
+  auto validated = resolved.unique();
+  m_hash = hashOf(resolved.source());
+  RendererPool::reload(resolved.creator());
+}
+
+void PyQuickJsRendererPool::watch(chrono::duration<double> interval) {
+  unwatch();
+  lock_guard<mutex> lock(m_watchMutex);
+  m_watching = true;
+  m_interval = interval;
+  m_watcher = thread(&PyQuickJsRendererPool::poll, this, interval);
+}
+
+void PyQuickJsRendererPool::unwatch() {
+  {
+    lock_guard<mutex> lock(m_watchMutex);
+    m_watching = false;
+  }
+  m_unwatched.notify_all();
+  if (m_watcher.joinable()) {
+    m_watcher.join();
+  }
+}
+
+void PyQuickJsRendererPool::prepareFork() {
+  auto &r = registry();
+  {
+    unique_lock<mutex> lock(r.guard);
+    r.forked.wait(lock, [&r] { return !r.forking; });
+    r.forking = true;
+  }
+  for (auto pool : r.pools) {
+    {
+      lock_guard<mutex> lock(pool->m_watchMutex);
+      pool->m_watchAfterFork = pool->m_watching;
+    }
+    pool->unwatch();
+    pool->pause();
+  }
+}
+
+void PyQuickJsRendererPool::afterForkInParent() {
+  afterFork([](PyQuickJsRendererPool &pool) { pool.resume(); });
+}
+
+void PyQuickJsRendererPool::afterForkInChild() {
+  afterFork([](PyQuickJsRendererPool &pool) { pool.reset(); });
+}
+
+void PyQuickJsRendererPool::afterFork(
+    const function<void(PyQuickJsRendererPool &)> &proceed) {
+  auto &r = registry();
+  {
+    lock_guard<mutex> lock(r.guard);
+    if (!r.forking) {
+      return;
+    }
+  }
+
+  /* Continue with every pool, even if one of them fails to watch. */
+  exception_ptr error;
+  for (auto pool : r.pools) {
+    try {
+      proceed(*pool);
+      if (pool->m_watchAfterFork) {
+        pool->watch(pool->m_interval);
+      }
+    } catch (...) {
+      if (!error) {
+        error = current_exception();
+      }
+    }
+  }
+
+  {
+    lock_guard<mutex> lock(r.guard);
+    r.forking = false;
+  }
+  r.forked.notify_all();
+  if (error) {
+    rethrow_exception(error);
+  }
+}
+
+void PyQuickJsRendererPool::poll(chrono::duration<double> interval) {
+  string reported;
+  while (true) {
+    {
+      unique_lock<mutex> lock(m_watchMutex);
+      auto unwatched = [this] { return !m_watching; };
+      if (m_unwatched.wait_for(lock, interval, unwatched)) {
+        return;
+      }
+    }
+
+    /* A broken source is tried again, after it has changed once more. */
+    string failure;
+    try {
+      auto hash = hashOf(m_builder.source());
+      {
+        lock_guard<mutex> lock(m_reloadMutex);
+        if (hash == m_hash) {
+          continue;
+        }
+        m_hash = hash;
+      }
+      reported.clear();
+      reload();
+    } catch (const exception &e) {
+      failure = e.what();
+    } catch (...) {
+      failure = "unknown error";
+    }
+    /* A source, which can't be read, is reported once, not on every poll. */
+    if (!failure.empty() && failure != reported) {
+      warn(failure);
+      reported = failure;
+    }
+  }
+}
@@ -0,0 +1,79 @@
+/**
+ * Copyright 2021 Torsten Mehnert
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+#include "pyquickjsrendererbuilder.h"
+#include "rendererpool.h"
+
+/**
+ * Pool of QuickJS renderers, which is able to reload its source.
+ *
+ * It keeps the builder it was created from, so it's able to call the
+ * creators again and replace its renderers when the views have changed.
+ *
+ * All pools can be paused before the process forks. The parent resumes with
+ * its workers, the child starts its own on the first render.
+ */
+class PyQuickJsRendererPool : public RendererPool {
+public:
+  PyQuickJsRendererPool(const PyQuickJsRendererBuilder &builder,
+                        std::size_t size);
+  ~PyQuickJsRendererPool() override;
+
+  /**
+   * Build renderers from the current source and swap them in.
+   *
+   * The new source is compiled once before, so the pool keeps its renderers
+   * when the source is broken.
+   */
+  void reload();
+
+  /** Reload in the background, whenever the source has changed. */
+  void watch(std::chrono::duration<double> interval);
+  void unwatch();
+
+  /** Pause all pools and stop their watchers, to fork the process safely. */
+  static void prepareFork();
+  /** Resume the pools paused by prepareFork() with their workers. */
+  static void afterForkInParent();
+  /** Reset the pools paused by prepareFork(), to start workers lazily. */
+  static void afterForkInChild();
+
+private:
+  PyQuickJsRendererPool(const PyQuickJsRendererBuilder &builder,
+                        const PyQuickJsRendererBuilder &resolved,
+                        std::size_t size);
+
+  static void afterFork(
+      const std::function<void(PyQuickJsRendererPool &)> &proceed);
+  void poll(std::chrono::duration<double> interval);
+
+  const PyQuickJsRendererBuilder m_builder;
+  std::mutex m_reloadMutex;
+  std::size_t m_hash;
+  std::mutex m_watchMutex;
+  std::condition_variable m_unwatched;
+  std::thread m_watcher;
+  bool m_watching = false;
+  std::chrono::duration<double> m_interval{};
+  bool m_watchAfterFork = false;
+};
@@ -14,12 +14,30 @@
 *  limitations under the License.
  */
 #include <pybind11/pybind11.h>
+#include "deadline.h"
+#include "instrumentedrenderer.h"
 #include "quickjsrenderer.h"
 #include "quickjsrendererbuilder.h"
+#include "quickjsrendererpool.h"
+#include "threadstate.h"
 
 PYBIND11_MODULE(quickjs, m) {
   m.doc() = "Python bindings for complate-cpp - QuickJs renderer";
 
+  /* Share the state of renders with the core module, whichever starts them. */
+  ThreadState::link(pybind11::module_::import("complatecpp.core")
+                        .attr("_thread_state")
+                        .cast<pybind11::capsule>());
+  Deadline::registerTranslator();
+  /* Without the hook, deadlines are checked only on writes and calls. */
+#ifdef COMPLATECPP_RUNTIME_HOOK
+  m.attr("runtime_hook") = true;
+#else
+  m.attr("runtime_hook") = false;
+#endif
+
   registerQuickJsRenderer(m);
+  registerQuickJsRendererPool(m);
   registerQuickJsRendererBuilder(m);
+  registerInstrumentedRenderer(m);
 }
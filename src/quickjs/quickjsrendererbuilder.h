@@ -15,12 +15,18 @@
  */
 #pragma once
 
-#include <complate/quickjs/quickjsrendererbuilder.h>
 #include <pybind11/functional.h>
 #include <pybind11/pybind11.h>
 #include <pybind11/stl.h>
 
+#include <thread>
+
+#include "mapper.h"
 #include "prototypes.h"
+#include "pyquickjsrendererbuilder.h"
+#include "pyquickjsrendererpool.h"
+#include "rendererpool.h"
+#include "sourcefile.h"
 
 static const char QUICKJS_RENDERER_BUILDER_DOC_CLASS[] = R"DELIM(
   Builder for QuickJsRenderer.
@@ -28,46 +34,274 @@ static const char QUICKJS_RENDERER_BUILDER_DOC_CLASS[] = R"DELIM(
   This class should support constructing a QuickJsRenderer.
 )DELIM";
 
+static const char QUICKJS_RENDERER_BUILDER_DOC_FROZEN_BINDINGS[] = R"DELIM(
+  Pass bindings, which are converted once and never change.
+
+  They are kept in a single native structure shared by all renderers built
+  by this builder, instead of being copied into every JavaScript runtime.
+  Views read them as usual, a field is copied into a runtime when a view
+  reads it for the first time. Assigning to them throws a TypeError in the
+  views. Frozen bindings replace other bindings of the same name.
+)DELIM";
+
+static const char QUICKJS_RENDERER_BUILDER_DOC_RECYCLE_AFTER[] = R"DELIM(
+  Replace a renderer by a new one after it rendered that many views.
+
+  A new renderer starts with a fresh JavaScript heap, which caps the memory
+  a long-running process uses. With heap_bytes, a renderer is replaced as
+  well, once its heap exceeds that size after a render. Measuring the heap
+  walks all of its objects. Renderers of a pool are replaced while the pool
+  is idle, so the new renderer is built off the request path. Pass 0 to
+  never replace renderers, which is the default. heap_bytes requires the
+  runtime hook.
+)DELIM";
+
+static const char QUICKJS_RENDERER_BUILDER_DOC_MEMORY_LIMIT[] = R"DELIM(
+  Limit the JavaScript heap of each renderer to that many bytes.
+
+  A view allocating beyond it fails with an out of memory error. Requires
+  the runtime hook, see runtime_hook.
+)DELIM";
+
+static const char QUICKJS_RENDERER_BUILDER_DOC_GC_THRESHOLD[] = R"DELIM(
+  Run the garbage collector, whenever the heap grew by that many bytes.
+
+  Together with collect_when_idle(), a high threshold moves garbage
+  collection off the request path. Requires the runtime hook.
+)DELIM";
+
+static const char QUICKJS_RENDERER_BUILDER_DOC_MAX_STACK_SIZE[] = R"DELIM(
+  Limit the stack of the views to that many bytes, 0 for no limit.
+
+  Deeper recursion fails with a stack overflow. Requires the runtime hook.
+)DELIM";
+
+static const char QUICKJS_RENDERER_BUILDER_DOC_COLLECT_WHEN_IDLE[] = R"DELIM(
+  Run the garbage collector of a pool's renderer between renders.
+
+  A worker collects after a render, when no other render is pending. It
+  holds the GIL meanwhile, since finalizers may release Python objects.
+  Requires the runtime hook.
+)DELIM";
+
+static const char QUICKJS_RENDERER_BUILDER_DOC_TIMEOUT[] = R"DELIM(
+  Abort renders, which take longer than timeout_ms milliseconds.
+
+  It applies to renders without a timeout_ms of their own, including
+  render_async(), render_iter() and render_batch() of a pool, and raises a
+  TimeoutError. The deadline is checked whenever a view writes to the stream
+  or calls into Python, and by the interrupt handler of QuickJS if the
+  module was built with the runtime hook, see runtime_hook. A renderer
+  interrupted that way is replaced by a new one. A pool stops waiting at the
+  deadline in any case and replaces a renderer stuck in JavaScript, like an
+  endless loop, by a new one. Pass 0 for no timeout, which is the default.
+)DELIM";
+
+static const char QUICKJS_RENDERER_BUILDER_DOC_BYTECODE_CACHE[] = R"DELIM(
+  Compile the views once to QuickJS bytecode, which renderers start from.
+
+  All renderers built by this builder, like the renderers of a pool, share
+  the bytecode instead of parsing and compiling the source each. With a
+  directory, the bytecode is also written to a file named after a hash of
+  the source, which later processes load instead of compiling. Bytecode of
+  another QuickJS version is compiled again. QuickJS runs bytecode without
+  verifying it, so only pass a directory nobody else can write to. Requires
+  the runtime hook, see runtime_hook.
+)DELIM";
+
+static const char QUICKJS_RENDERER_BUILDER_DOC_STATIC_VIEWS[] = R"DELIM(
+  Declare views, which render the same output on every render.
+
+  Pass a list of view names, or a dict of view names and the parameters to
+  render them with. These views are rendered once when the renderer is
+  built, renders afterwards write that output without running JavaScript,
+  whatever parameters are passed. The output is shared by all renderers of a
+  pool or of many().
+
+  Other views splice it into their own through the global complatecppStatic,
+  which holds the output of each static view as a string of raw HTML, e.g.
+  safe(complatecppStatic.Head) with the safe() of complate. The global isn't
+  defined, while the static views themselves are rendered.
+)DELIM";
+
+static const char QUICKJS_RENDERER_BUILDER_DOC_NATIVE_HELPERS[] = R"DELIM(
+  Expose native helper functions to your views as global complatecpp.
+
+  complatecpp.escapeHtml(str, attribute=false) escapes &, < and >, plus " and
+  ' for attributes. complatecpp.join(array, separator=",") joins strings,
+  numbers and booleans. complatecpp.formatNumber(number, decimals=0,
+  thousands=",", point=".") formats a number with grouped thousands.
+  They run natively without the GIL, which makes them faster than the same
+  code in JavaScript or as Python bindings for large outputs.
+)DELIM";
+
+static const char QUICKJS_RENDERER_BUILDER_DOC_MANY[] = R"DELIM(
+  Build several renderer instances.
+
+  The source and bindings creators are called only once, all renderers
+  share their results and the prototypes.
+)DELIM";
+
 void registerQuickJsRendererBuilder(pybind11::module_ &m) {
   namespace py = pybind11;
   using namespace std;
   using namespace complate;
+  using Builder = PyQuickJsRendererBuilder;
 
-  py::class_<QuickJsRendererBuilder>(m, "QuickJsRendererBuilder")
+  py::class_<Builder>(m, "QuickJsRendererBuilder")
       .def(py::init<>(),
            "Construct a builder to create a QuickJsRenderer instance.")
-      .def("source", py::overload_cast<string>(&QuickJsRendererBuilder::source),
+      .def("source", py::overload_cast<string>(&Builder::source),
            "Pass the content of your views.js bundle as string.",
            py::arg("sourceStr"))
       .def("source",
-           py::overload_cast<QuickJsRendererBuilder::SourceCreator>(
-               &QuickJsRendererBuilder::source),
+           py::overload_cast<Builder::SourceCreator>(&Builder::source),
            "Pass a function that return the content of your views.js bundle.",
            py::arg("sourceCreator"))
+      .def(
+          "source_file",
+          [](Builder &builder, const string &path) {
+            builder.source(Builder::SourceCreator(
+                [path]() { return SourceFile::read(path); }));
+            return ref(builder);
+          },
+          "Pass the path of your views.js bundle, which is read natively.",
+          py::arg("path"))
 
+      .def(
+          "bindings",
+          [](Builder &builder, const py::dict &bindings) {
+            builder.bindings(Mapper::python_to_object(bindings));
+            return ref(builder);
+          },
+          "Pass your bindings.", py::arg("bindingsObj"))
       .def("bindings",
-           py::overload_cast<Object>(&QuickJsRendererBuilder::bindings),
-           "Pass your bindings.", py::arg("bindingsObj"))
-      .def("bindings",
-           py::overload_cast<QuickJsRendererBuilder::BindingsCreator>(
-               &QuickJsRendererBuilder::bindings),
+           py::overload_cast<Builder::BindingsCreator>(&Builder::bindings),
            "Pass a function that return your bindings.",
            py::arg("bindingsCreator"))
+      .def(
+          "frozen_bindings",
+          [](Builder &builder, const py::dict &bindings) {
+            builder.frozenBindings(Mapper::python_to_object(bindings));
+            return ref(builder);
+          },
+          QUICKJS_RENDERER_BUILDER_DOC_FROZEN_BINDINGS, py::arg("bindings"))
       .def(
           "prototypes",
-          [](QuickJsRendererBuilder &builder, const py::list &types) {
+          [](Builder &builder, const py::list &types) {
             builder.prototypes(Prototypes::create_prototypes(types));
             return ref(builder);
           },
           "Pass your Python classes, which you want to use in views.")
       .def(
           "prototypes",
-          [](QuickJsRendererBuilder &builder, const py::function &creator) {
+          [](Builder &builder, const py::function &creator) {
             builder.prototypes(Prototypes::create_prototypes(creator()));
             return ref(builder);
           },
           "Pass a function that return Python classes, you want to use.")
-      .def("unique", &QuickJsRendererBuilder::unique,
-           "Build a renderer instance")
+      .def(
+          "recycle_after",
+          [](Builder &builder, size_t renders, size_t heapBytes) {
+            builder.recycleAfter(renders, heapBytes);
+            return ref(builder);
+          },
+          QUICKJS_RENDERER_BUILDER_DOC_RECYCLE_AFTER, py::arg("renders"),
+          py::arg("heap_bytes") = 0)
+      .def(
+          "memory_limit",
+          [](Builder &builder, size_t bytes) {
+            builder.memoryLimit(bytes);
+            return ref(builder);
+          },
+          QUICKJS_RENDERER_BUILDER_DOC_MEMORY_LIMIT, py::arg("bytes"))
+      .def(
+          "gc_threshold",
+          [](Builder &builder, size_t bytes) {
+            builder.gcThreshold(bytes);
+            return ref(builder);
+          },
+          QUICKJS_RENDERER_BUILDER_DOC_GC_THRESHOLD, py::arg("bytes"))
+      .def(
+          "max_stack_size",
+          [](Builder &builder, size_t bytes) {
+            builder.maxStackSize(bytes);
+            return ref(builder);
+          },
+          QUICKJS_RENDERER_BUILDER_DOC_MAX_STACK_SIZE, py::arg("bytes"))
+      .def(
+          "collect_when_idle",
+          [](Builder &builder, bool enabled) {
+            builder.collectWhenIdle(enabled);
+            return ref(builder);
+          },
+          QUICKJS_RENDERER_BUILDER_DOC_COLLECT_WHEN_IDLE,
+          py::arg("enabled") = true)
+      .def(
+          "native_helpers",
+          [](Builder &builder, bool enabled) {
+            builder.nativeHelpers(enabled);
+            return ref(builder);
+          },
+          QUICKJS_RENDERER_BUILDER_DOC_NATIVE_HELPERS,
+          py::arg("enabled") = true)
+      .def(
+          "timeout",
+          [](Builder &builder, double timeoutMs) {
+            builder.timeout(timeoutMs);
+            return ref(builder);
+          },
+          QUICKJS_RENDERER_BUILDER_DOC_TIMEOUT, py::arg("timeout_ms"))
+      .def(
+          "bytecode_cache",
+          [](Builder &builder, const string &directory) {
+            builder.bytecodeCache(directory);
+            return ref(builder);
+          },
+          QUICKJS_RENDERER_BUILDER_DOC_BYTECODE_CACHE,
+          py::arg("directory") = "")
+      .def(
+          "static_views",
+          [](Builder &builder, const py::list &views) {
+            map<string, Object> parameters;
+            for (auto view : views) {
+              parameters.emplace(view.cast<string>(), Object());
+            }
+            builder.staticViews(move(parameters));
+            return ref(builder);
+          },
+          QUICKJS_RENDERER_BUILDER_DOC_STATIC_VIEWS, py::arg("views"))
+      .def(
+          "static_views",
+          [](Builder &builder, const py::dict &views) {
+            map<string, Object> parameters;
+            for (auto item : views) {
+              parameters.emplace(
+                  item.first.cast<string>(),
+                  Mapper::python_to_object(item.second.cast<py::dict>()));
+            }
+            builder.staticViews(move(parameters));
+            return ref(builder);
+          },
+          QUICKJS_RENDERER_BUILDER_DOC_STATIC_VIEWS, py::arg("views"))
+      .def("unique", &Builder::unique, "Build a renderer instance")
+      .def(
+          "many",
+          [](const Builder &builder, size_t count) {
+            auto resolved = builder.resolved();
+            py::list renderers;
+            for (size_t i = 0; i < count; ++i) {
+              renderers.append(py::cast(resolved.unique()));
+            }
+            return renderers;
+          },
+          QUICKJS_RENDERER_BUILDER_DOC_MANY, py::arg("count"))
+      .def(
+          "pool",
+          [](const Builder &builder, size_t size) {
+            return make_unique<PyQuickJsRendererPool>(builder, size);
+          },
+          "Build a pool of renderers, which render on their own threads.",
+          py::arg("size") = max(thread::hardware_concurrency(), 1u))
       .doc() = QUICKJS_RENDERER_BUILDER_DOC_CLASS;
 }
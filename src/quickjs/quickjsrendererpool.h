@@ -0,0 +1,218 @@
+/**
+ * Copyright 2021 Torsten Mehnert
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+#pragma once
+
+#include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
+
+#include <chrono>
+
+#include "asyncrender.h"
+#include "batch.h"
+#include "mapper.h"
+#include "outputstream.h"
+#include "pyquickjsrendererbuilder.h"
+#include "pyquickjsrendererpool.h"
+#include "rendererpool.h"
+#include "renderiterator.h"
+
+static const char QUICKJS_RENDERER_POOL_DOC_CLASS[] = R"DELIM(
+  Renderer which renders concurrently on a pool of QuickJS renderers.
+
+  Each renderer of the pool lives on its own native thread. A render is
+  handed over to the next idle renderer and the GIL is released until it is
+  done. Only calls into Python (bindings, prototypes or a Python Stream)
+  acquire the GIL again, so renders from several Python threads will run in
+  parallel. You should use QuickJsRendererBuilder.pool() to create an object
+  of this class.
+)DELIM";
+
+static const char QUICKJS_RENDERER_POOL_DOC_RENDER_ITER[] = R"DELIM(
+  Render a view and iterate over the output while it's generated.
+
+  The render runs on the pool, chunks of chunk_size bytes (or less, when the
+  view flushes the stream) are returned as bytes. Use it with "for" or
+  "async for" to start sending the response before the render is done.
+)DELIM";
+
+static const char QUICKJS_RENDERER_POOL_DOC_BATCH[] = R"DELIM(
+  Render several views at once, spread across the renderers of the pool.
+
+  The items are pairs of view and parameters, which are a dict or a JSON
+  string. The outputs are returned in the order of the items, as str or as
+  UTF-8 encoded bytes when as_bytes is set.
+)DELIM";
+
+static const char QUICKJS_RENDERER_POOL_DOC_RENDER_ASYNC[] = R"DELIM(
+  Render a view on the pool and await its output in an asyncio application.
+
+  Returns an asyncio future, which is completed on the event loop when the
+  render is done. The event loop keeps running meanwhile, the output is a
+  str, or UTF-8 encoded bytes when as_bytes is set.
+)DELIM";
+
+static const char QUICKJS_RENDERER_POOL_DOC_RELOAD[] = R"DELIM(
+  Call the creators of the builder again and swap in new renderers.
+
+  The new source is compiled before any renderer is replaced, a broken
+  source raises an error and the pool keeps rendering with the old one.
+  Renders already running finish with the old source, idle renderers are
+  replaced right away and busy ones as soon as their render is done.
+)DELIM";
+
+static const char QUICKJS_RENDERER_POOL_DOC_WATCH[] = R"DELIM(
+  Reload the pool in the background, whenever the source has changed.
+
+  The source is checked every interval seconds, which is cheap for sources
+  passed by source_file(). When the new source is broken, the pool keeps its
+  renderers until the source changes again. Sources, which are broken or
+  can't be read, are reported by a RuntimeWarning.
+)DELIM";
+
+static const char QUICKJS_DOC_PREPARE_FORK[] = R"DELIM(
+  Pause all pools, before the process is forked.
+
+  The workers of every QuickJsRendererPool finish their current render and
+  wait, so no view is running during the fork. Renders started meanwhile
+  wait until the pool is resumed. Renderers built by unique() or many() are
+  not affected, build them before forking to share their memory with the
+  children. register_at_fork() registers this hook together with the
+  after_fork hooks.
+)DELIM";
+
+static const char QUICKJS_DOC_AFTER_FORK_IN_PARENT[] = R"DELIM(
+  Resume all pools paused by prepare_fork(), in the parent.
+
+  The workers continue with their renderers, nothing is rebuilt. Pools which
+  were watching their source continue to do so.
+)DELIM";
+
+static const char QUICKJS_DOC_AFTER_FORK_IN_CHILD[] = R"DELIM(
+  Reset all pools paused by prepare_fork(), in the child.
+
+  The worker threads exist only in the parent. Each pool starts new workers
+  on its first render, which create their renderers from the source and
+  bindings resolved before the fork. Pools which were watching their source
+  continue to do so.
+)DELIM";
+
+static const char RENDER_ITERATOR_DOC_CLASS[] = R"DELIM(
+  Iterator over the output of a render running on a QuickJsRendererPool.
+
+  It supports both the iterator and the asynchronous iterator protocol.
+  Dropping the iterator before the end aborts the render.
+)DELIM";
+
+void registerQuickJsRendererPool(pybind11::module_ &m) {
+  namespace py = pybind11;
+  using namespace std;
+  using namespace complate;
+  using Pool = PyQuickJsRendererPool;
+
+  py::class_<RenderIterator>(m, "RenderIterator")
+      .def("__iter__", [](py::object self) { return self; })
+      .def("__next__", &RenderIterator::next)
+      .def("__aiter__", [](py::object self) { return self; })
+      .def("__anext__", &RenderIterator::anext)
+      .doc() = RENDER_ITERATOR_DOC_CLASS;
+
+  py::class_<Pool, Renderer>(m, "QuickJsRendererPool")
+      .def(py::init<const PyQuickJsRendererBuilder &, size_t>(),
+           "Construct a pool of QuickJsRenderer instances, use "
+           "QuickJsRendererBuilder.pool() instead.",
+           py::arg("builder"), py::arg("size"))
+      .def_property_readonly("size", &RendererPool::size,
+                             "The number of renderers in this pool.")
+      .def("reload", &Pool::reload, QUICKJS_RENDERER_POOL_DOC_RELOAD,
+           py::call_guard<py::gil_scoped_release>())
+      .def(
+          "watch",
+          [](Pool &pool, double interval) {
+            pool.watch(chrono::duration<double>(interval));
+          },
+          QUICKJS_RENDERER_POOL_DOC_WATCH, py::arg("interval") = 1.0,
+          py::call_guard<py::gil_scoped_release>())
+      .def("unwatch", &Pool::unwatch,
+           "Stop reloading when the source changes.",
+           py::call_guard<py::gil_scoped_release>())
+      .def(
+          "render_iter",
+          [](Pool &pool, const string &view, const string &parameters,
+             size_t chunkSize) {
+            return RenderIterator(pool, view, parameters, chunkSize);
+          },
+          QUICKJS_RENDERER_POOL_DOC_RENDER_ITER, py::keep_alive<0, 1>(),
+          py::arg("view"), py::arg("parameters"), py::arg("chunk_size") = 8192)
+      .def(
+          "render_iter",
+          [](Pool &pool, const string &view, const py::dict &parameters,
+             size_t chunkSize) {
+            return RenderIterator(pool, view,
+                                  Mapper::python_to_object(parameters),
+                                  chunkSize);
+          },
+          QUICKJS_RENDERER_POOL_DOC_RENDER_ITER, py::keep_alive<0, 1>(),
+          py::arg("view"), py::arg("parameters"), py::arg("chunk_size") = 8192)
+      .def(
+          "render_async",
+          [](Pool &pool, const string &view, const string &parameters,
+             bool asBytes) {
+            return AsyncRender::start(pool, view, parameters, asBytes);
+          },
+          QUICKJS_RENDERER_POOL_DOC_RENDER_ASYNC, py::arg("view"),
+          py::arg("parameters"), py::arg("as_bytes") = false)
+      .def(
+          "render_async",
+          [](Pool &pool, const string &view, const py::dict &parameters,
+             bool asBytes, bool lazy) {
+            return AsyncRender::start(
+                pool, view, Mapper::python_to_object(parameters, lazy),
+                asBytes);
+          },
+          QUICKJS_RENDERER_POOL_DOC_RENDER_ASYNC, py::arg("view"),
+          py::arg("parameters"), py::arg("as_bytes") = false,
+          py::arg("lazy") = false)
+      .def(
+          "render_batch",
+          [](Pool &pool, const py::iterable &items, bool asBytes,
+             bool lazy) {
+            Batch batch(items, lazy);
+            vector<RendererPool::Task> tasks;
+            for (size_t i = 0; i < batch.size(); ++i) {
+              tasks.emplace_back([&pool, &batch, i](Renderer &renderer) {
+                OutputStream stream;
+                pool.renderWithTimeout(stream, [&](Stream &out) {
+                  batch.render(renderer, i, out);
+                });
+                batch.set(i, stream.take());
+              });
+            }
+            pool.runAll(tasks);
+            return batch.outputs(asBytes);
+          },
+          QUICKJS_RENDERER_POOL_DOC_BATCH, py::arg("items"),
+          py::arg("as_bytes") = false, py::arg("lazy") = false)
+      .doc() = QUICKJS_RENDERER_POOL_DOC_CLASS;
+
+  m.def("prepare_fork", &Pool::prepareFork, QUICKJS_DOC_PREPARE_FORK,
+        py::call_guard<py::gil_scoped_release>());
+  m.def("after_fork_in_parent", &Pool::afterForkInParent,
+        QUICKJS_DOC_AFTER_FORK_IN_PARENT,
+        py::call_guard<py::gil_scoped_release>());
+  m.def("after_fork_in_child", &Pool::afterForkInChild,
+        QUICKJS_DOC_AFTER_FORK_IN_CHILD,
+        py::call_guard<py::gil_scoped_release>());
+}
@@ -0,0 +1,59 @@
+/**
+ * Copyright 2021 Torsten Mehnert
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+#include "recyclingrenderer.h"
+
+#include "runtimerenderer.h"
+
+using namespace std;
+using namespace complate;
+
+RecyclingRenderer::RecyclingRenderer(RendererPool::Creator creator,
+                                     size_t renders, size_t heapBytes)
+    : m_creator(move(creator)),
+      m_renderer(m_creator()),
+      m_limit(renders),
+      m_heapLimit(heapBytes) {}
+
+void RecyclingRenderer::render(const string &view, const Object &parameters,
+                               Stream &stream) {
+  next().render(view, parameters, stream);
+  measure();
+}
+
+void RecyclingRenderer::render(const string &view, const string &parameters,
+                               Stream &stream) {
+  next().render(view, parameters, stream);
+  measure();
+}
+
+Renderer &RecyclingRenderer::next() {
+  if ((m_limit > 0 && m_renders >= m_limit) ||
+      (m_heapLimit > 0 && m_heap >= m_heapLimit)) {
+    m_renderer = m_creator();
+    m_renders = 0;
+    m_heap = 0;
+  }
+  ++m_renders;
+  return *m_renderer;
+}
+
+void RecyclingRenderer::measure() {
+  if (m_heapLimit > 0) {
+    if (auto runtime = RuntimeRenderer::of(*m_renderer)) {
+      m_heap = runtime->memory().bytes;
+    }
+  }
+}
@@ -0,0 +1,52 @@
+/**
+ * Copyright 2021 Torsten Mehnert
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+#pragma once
+
+#include <complate/core/renderer.h>
+
+#include <memory>
+
+#include "rendererpool.h"
+
+/**
+ * Renderer which replaces its renderer by a new one after a number of renders.
+ *
+ * A new renderer starts with a fresh JavaScript runtime, so the heap of a
+ * long-running process doesn't grow with every render. With heapBytes, the
+ * renderer is replaced as well, once the heap of its runtime exceeds that
+ * size after a render.
+ */
+class RecyclingRenderer : public complate::Renderer {
+public:
+  RecyclingRenderer(RendererPool::Creator creator, std::size_t renders,
+                    std::size_t heapBytes = 0);
+
+  void render(const std::string &view, const complate::Object &parameters,
+              complate::Stream &stream) override;
+  void render(const std::string &view, const std::string &parameters,
+              complate::Stream &stream) override;
+
+private:
+  complate::Renderer &next();
+  void measure();
+
+  RendererPool::Creator m_creator;
+  std::unique_ptr<complate::Renderer> m_renderer;
+  const std::size_t m_limit;
+  const std::size_t m_heapLimit;
+  std::size_t m_renders = 0;
+  std::size_t m_heap = 0;
+};
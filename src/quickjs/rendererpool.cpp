@@ -0,0 +1,683 @@
+/**
+ * Copyright 2021 Torsten Mehnert
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+#include "rendererpool.h"
+
+#include <pybind11/pybind11.h>
+
+#include <algorithm>
+#include <iterator>
+#include <stdexcept>
+#include <utility>
+
+#include "renderstats.h"
+#include "runtimerenderer.h"
+
+using namespace std;
+using namespace complate;
+namespace py = pybind11;
+
+namespace {
+/** Worker running on this thread, used by tasks to identify it. */
+thread_local void *currentWorker = nullptr;
+
+constexpr chrono::steady_clock::duration MIN_RETRY_DELAY =
+    chrono::milliseconds(100);
+constexpr chrono::steady_clock::duration MAX_RETRY_DELAY = chrono::seconds(10);
+
+/** Renderer of a worker without renderer, which fails every render. */
+class FailingRenderer : public Renderer {
+public:
+  explicit FailingRenderer(exception_ptr error) : m_error(move(error)) {}
+
+  void render(const string &, const Object &, Stream &) override {
+    rethrow_exception(m_error);
+  }
+
+  void render(const string &, const string &, Stream &) override {
+    rethrow_exception(m_error);
+  }
+
+private:
+  exception_ptr m_error;
+};
+
+/**
+ * Output of a render, written to the stream of the caller afterwards.
+ *
+ * For a measured render, the writes of the view are kept apart, so they
+ * reach the caller's stream and its stats as the view made them.
+ */
+class Output : public Stream {
+public:
+  explicit Output(bool measured) : m_measured(measured) {}
+
+  void write(const char *str, int len) override {
+    m_output.append(str, len);
+    mark();
+  }
+
+  void writeln(const char *str, int len) override {
+    m_output.append(str, len);
+    m_output.push_back('\n');
+    mark();
+  }
+
+  void flush() override {}
+
+  void writeTo(Stream &stream) const {
+    size_t start = 0;
+    for (auto end : m_ends) {
+      stream.write(m_output.data() + start, static_cast<int>(end - start));
+      start = end;
+    }
+    if (start < m_output.size()) {
+      stream.write(m_output.data() + start,
+                   static_cast<int>(m_output.size() - start));
+    }
+  }
+
+private:
+  void mark() {
+    if (m_measured) {
+      m_ends.push_back(m_output.size());
+    }
+  }
+
+  const bool m_measured;
+  string m_output;
+  vector<size_t> m_ends;
+};
+
+/** Report a renderer, which couldn't be created, requires the GIL. */
+void warn(const exception_ptr &error) {
+  string message = "A renderer of the pool couldn't be created: ";
+  try {
+    rethrow_exception(error);
+  } catch (const exception &e) {
+    message += e.what();
+  } catch (...) {
+    message += "unknown error";
+  }
+  if (PyErr_WarnEx(PyExc_RuntimeWarning, message.c_str(), 1) < 0) {
+    PyErr_WriteUnraisable(nullptr);
+  }
+}
+}  // namespace
+
+/**
+ * State of a render with a deadline, shared by the caller and the worker.
+ *
+ * The worker may outlive the caller, when it's abandoned, so it owns its
+ * parameters and its output.
+ */
+struct RendererPool::Pending {
+  explicit Pending(bool measured) : output(measured) {}
+
+  mutex guard;
+  Worker *worker = nullptr;
+  /** Set by the caller, when it stopped waiting at the deadline. */
+  bool cancelled = false;
+  bool finished = false;
+  promise<void> done;
+  Output output;
+  RenderStats stats;
+};
+
+RendererPool::RendererPool(Creator creator, size_t size, Options options)
+    : m_creator(move(creator)), m_size(size), m_options(options) {
+  if (size == 0) {
+    throw invalid_argument("A pool needs at least one renderer");
+  }
+
+  /* Creators may call into Python, so workers must be able to get the GIL. */
+  py::gil_scoped_release release;
+  start();
+}
+
+RendererPool::~RendererPool() {
+  py::gil_scoped_release release;
+  stop();
+}
+
+void RendererPool::render(const string &view, const Object &parameters,
+                          Stream &stream) {
+  auto at = Deadline::current().at;
+  if (!at) {
+    at = Deadline::after(m_options.timeoutMs);
+  }
+  if (at) {
+    renderWithin(*at, view, parameters, stream);
+    return;
+  }
+  run([&](Renderer &renderer) { renderer.render(view, parameters, stream); });
+}
+
+void RendererPool::render(const string &view, const string &parameters,
+                          Stream &stream) {
+  auto at = Deadline::current().at;
+  if (!at) {
+    at = Deadline::after(m_options.timeoutMs);
+  }
+  if (at) {
+    renderWithin(*at, view, parameters, stream);
+    return;
+  }
+  run([&](Renderer &renderer) { renderer.render(view, parameters, stream); });
+}
+
+void RendererPool::renderWithTimeout(
+    Stream &stream, const function<void(Stream &)> &render) const {
+  auto at = Deadline::after(m_options.timeoutMs);
+  if (!at || Deadline::current().at) {
+    /* A deadline of the caller takes precedence over the default. */
+    render(stream);
+    return;
+  }
+  try {
+    Deadline::run(at, [&] {
+      DeadlineStream checked(stream);
+      render(checked);
+    });
+  } catch (const RenderTimeout &) {
+    /* Only tasks running on a worker render on a renderer of the pool. */
+    if (auto worker = static_cast<Worker *>(currentWorker)) {
+      worker->poisoned = true;
+    }
+    throw;
+  }
+}
+
+void RendererPool::run(const Task &task) {
+  py::gil_scoped_release release;
+  promise<void> done;
+  auto future = done.get_future();
+  /* The caller is blocked meanwhile, so the worker may add to its stats. */
+  auto stats = RenderStats::current();
+  submit([&task, &done, stats](Renderer &renderer) {
+    RenderStats::Scope scope(stats);
+    try {
+      task(renderer);
+      done.set_value();
+    } catch (...) {
+      done.set_exception(current_exception());
+    }
+  });
+  future.get();
+}
+
+void RendererPool::runAll(const vector<Task> &tasks) {
+  py::gil_scoped_release release;
+  vector<promise<void>> done(tasks.size());
+  vector<future<void>> futures;
+  for (size_t i = 0; i < tasks.size(); ++i) {
+    futures.push_back(done[i].get_future());
+    submit([&task = tasks[i], &done = done[i]](Renderer &renderer) {
+      try {
+        task(renderer);
+        done.set_value();
+      } catch (...) {
+        done.set_exception(current_exception());
+      }
+    });
+  }
+
+  exception_ptr error;
+  for (auto &future : futures) {
+    try {
+      future.get();
+    } catch (...) {
+      if (!error) {
+        error = current_exception();
+      }
+    }
+  }
+  if (error) {
+    rethrow_exception(error);
+  }
+}
+
+void RendererPool::submit(Task task) {
+  {
+    lock_guard<mutex> lock(*m_mutex);
+    if (m_stopped) {
+      throw logic_error("The pool has been stopped");
+    }
+    if (m_workers.empty()) {
+      /* Reset after a fork, nobody waits for the renderers to be created. */
+      for (size_t i = 0; i < m_size; ++i) {
+        spawn(nullptr);
+      }
+    }
+    m_tasks.push_back(move(task));
+  }
+  m_pending->notify_one();
+}
+
+void RendererPool::reload(Creator creator) {
+  {
+    lock_guard<mutex> lock(*m_mutex);
+    swap(m_creator, creator);
+    ++m_generation;
+  }
+  m_pending->notify_all();
+}
+
+void RendererPool::pause() {
+  unique_lock<mutex> lock(*m_mutex);
+  if (m_stopped || m_paused) {
+    return;
+  }
+  m_paused = true;
+  m_pending->notify_all();
+  m_idle->wait(lock, [this] {
+    return all_of(m_workers.begin(), m_workers.end(),
+                  [](const auto &w) { return w->paused || w->exited; });
+  });
+}
+
+void RendererPool::resume() {
+  {
+    lock_guard<mutex> lock(*m_mutex);
+    m_paused = false;
+  }
+  m_pending->notify_all();
+}
+
+void RendererPool::reset() {
+  /* Leaked, destroying them in the child would touch the parent's threads. */
+  static auto orphans = new vector<shared_ptr<Worker>>();
+  static auto orphanedTasks = new deque<Task>();
+  /*
+   * The parent's workers still count as waiters of the condition variables,
+   * and an abandoned one may have held the mutex at the fork. The child is
+   * single threaded here, so they are replaced without locking.
+   */
+  static auto orphanedMutexes = new vector<unique_ptr<mutex>>();
+  static auto orphanedConditions =
+      new vector<unique_ptr<condition_variable>>();
+  orphanedMutexes->push_back(exchange(m_mutex, make_unique<mutex>()));
+  for (auto condition : {&m_pending, &m_exited, &m_idle}) {
+    orphanedConditions->push_back(
+        exchange(*condition, make_unique<condition_variable>()));
+  }
+
+  move(m_workers.begin(), m_workers.end(), back_inserter(*orphans));
+  m_workers.clear();
+  move(m_abandoned.begin(), m_abandoned.end(), back_inserter(*orphans));
+  m_abandoned.clear();
+  move(m_tasks.begin(), m_tasks.end(), back_inserter(*orphanedTasks));
+  m_tasks.clear();
+  m_failure = nullptr;
+  m_paused = false;
+}
+
+size_t RendererPool::size() const { return m_size; }
+
+void RendererPool::renderWithin(Deadline::Clock::time_point at,
+                                const string &view, Parameters parameters,
+                                Stream &stream) {
+  auto stats = RenderStats::current();
+  auto pending = make_shared<Pending>(stats != nullptr);
+  auto future = pending->done.get_future();
+  {
+    py::gil_scoped_release release;
+    submit([pending, at, view, parameters = move(parameters)](
+               Renderer &renderer) {
+      auto worker = static_cast<Worker *>(currentWorker);
+      {
+        lock_guard<mutex> lock(pending->guard);
+        if (pending->cancelled) {
+          return;
+        }
+        pending->worker = worker;
+      }
+      RenderStats::Scope scope(&pending->stats);
+      exception_ptr error;
+      try {
+        Deadline::run(at, [&] {
+          DeadlineStream checked(pending->output);
+          visit([&](const auto &p) { renderer.render(view, p, checked); },
+                parameters);
+        });
+      } catch (const RenderTimeout &) {
+        /* The view was interrupted anywhere, don't trust its runtime. */
+        worker->poisoned = true;
+        error = current_exception();
+      } catch (...) {
+        error = current_exception();
+      }
+
+      lock_guard<mutex> lock(pending->guard);
+      pending->finished = true;
+      if (error) {
+        pending->done.set_exception(error);
+      } else {
+        pending->done.set_value();
+      }
+    });
+
+    if (future.wait_until(at) == future_status::timeout) {
+      Worker *worker = nullptr;
+      {
+        lock_guard<mutex> lock(pending->guard);
+        if (!pending->finished) {
+          pending->cancelled = true;
+          worker = pending->worker;
+        }
+      }
+      if (worker) {
+        abandon(worker, *pending);
+      }
+      if (pending->cancelled) {
+        Deadline::expire();
+      }
+    }
+    future.get();
+  }
+
+  if (stats) {
+    stats->add(pending->stats);
+  }
+  /* Rendered in time, so writing it out must not fail at the deadline. */
+  Deadline::Lift lift;
+  pending->output.writeTo(stream);
+  stream.flush();
+}
+
+void RendererPool::abandon(Worker *worker, Pending &pending) {
+  lock_guard<mutex> lock(*m_mutex);
+  reap();
+  lock_guard<mutex> guard(pending.guard);
+  if (pending.finished) {
+    return;
+  }
+  /* The view ran past the deadline, even if the worker isn't abandoned. */
+  worker->poisoned = true;
+  if (m_stopped || m_abandoned.size() >= m_size) {
+    /* Left to finish the view, rather than piling up threads. */
+    return;
+  }
+  auto it = find_if(m_workers.begin(), m_workers.end(),
+                    [worker](const auto &w) { return w.get() == worker; });
+  if (it == m_workers.end()) {
+    return;
+  }
+  worker->abandoned = true;
+  m_abandoned.push_back(move(*it));
+  m_workers.erase(it);
+  spawn(nullptr);
+}
+
+void RendererPool::reap() {
+  auto exited = partition(m_abandoned.begin(), m_abandoned.end(),
+                          [](const auto &w) { return !w->exited; });
+  for (auto it = exited; it != m_abandoned.end(); ++it) {
+    (*it)->thread.join();
+  }
+  m_abandoned.erase(exited, m_abandoned.end());
+}
+
+void RendererPool::start() {
+  vector<promise<void>> started(m_size);
+  vector<future<void>> ready;
+  {
+    lock_guard<mutex> lock(*m_mutex);
+    for (auto &promise : started) {
+      ready.push_back(promise.get_future());
+      spawn(&promise);
+    }
+  }
+  try {
+    for (auto &future : ready) {
+      future.get();
+    }
+  } catch (...) {
+    {
+      lock_guard<mutex> lock(*m_mutex);
+      m_stopped = true;
+    }
+    join();
+    throw;
+  }
+}
+
+void RendererPool::join() {
+  m_pending->notify_all();
+  vector<shared_ptr<Worker>> workers;
+  {
+    unique_lock<mutex> lock(*m_mutex);
+    /* Abandoned workers are interrupted at their deadline, if possible. */
+    auto exited = [](const auto &w) { return w->exited; };
+    m_exited->wait(lock, [this, &exited] {
+      return all_of(m_workers.begin(), m_workers.end(), exited) &&
+             all_of(m_abandoned.begin(), m_abandoned.end(), exited);
+    });
+    swap(workers, m_workers);
+    move(m_abandoned.begin(), m_abandoned.end(), back_inserter(workers));
+    m_abandoned.clear();
+  }
+  for (auto &worker : workers) {
+    worker->thread.join();
+  }
+}
+
+void RendererPool::spawn(promise<void> *started) {
+  auto worker = make_shared<Worker>();
+  worker->thread = thread(&RendererPool::work, this, worker, started);
+  m_workers.push_back(move(worker));
+}
+
+void RendererPool::work(shared_ptr<Worker> self, promise<void> *started) {
+  currentWorker = self.get();
+  /* reload() swaps the creator, start with the current one. */
+  Creator creator;
+  size_t generation;
+  {
+    lock_guard<mutex> lock(*m_mutex);
+    creator = m_creator;
+    generation = m_generation;
+  }
+
+  unique_ptr<Renderer> renderer;
+  if (started) {
+    try {
+      renderer = creator();
+      started->set_value();
+    } catch (...) {
+      started->set_exception(current_exception());
+      lock_guard<mutex> lock(*m_mutex);
+      self->exited = true;
+      m_exited->notify_all();
+      return;
+    }
+  } else {
+    /* Nobody waits for it to start, it's out of rotation on failure. */
+    replace(*self, renderer, creator);
+  }
+
+  size_t renders = 0;
+  size_t heap = 0;
+  /* Set after a render, until the garbage collector ran. */
+  bool garbage = false;
+  while (true) {
+    Creator replacement;
+    Task task;
+    exception_ptr failure;
+    bool collecting = false;
+    {
+      unique_lock<mutex> lock(*m_mutex);
+      if (m_paused && !m_stopped) {
+        self->paused = true;
+        m_idle->notify_all();
+        m_pending->wait(lock, [this] { return !m_paused || m_stopped; });
+        self->paused = false;
+      }
+      auto running = [this] { return !m_stopped && !m_paused; };
+      if (running() && self->failed) {
+        /* Out of rotation until the retry is due or the creator changed. */
+        m_pending->wait_until(
+            lock, self->retryAt, [this, &running, generation] {
+              return !running() || generation != m_generation ||
+                     (unavailable() && !m_tasks.empty());
+            });
+        if (running() && (generation != m_generation ||
+                          chrono::steady_clock::now() >= self->retryAt)) {
+          generation = m_generation;
+          replacement = m_creator;
+        }
+      } else if (running() && (self->poisoned || recycleDue(renders, heap))) {
+        self->poisoned = false;
+        replacement = m_creator;
+      } else if (running() && garbage && m_tasks.empty() &&
+                 generation == m_generation) {
+        /* Idle after a render, so collect before waiting for a task. */
+        garbage = false;
+        collecting = true;
+      } else {
+        m_pending->wait(lock, [this, &running, generation] {
+          return !running() || !m_tasks.empty() ||
+                 generation != m_generation;
+        });
+        if (generation != m_generation && running()) {
+          generation = m_generation;
+          replacement = m_creator;
+        }
+      }
+
+      if (!replacement && !collecting) {
+        if (m_tasks.empty() || !running()) {
+          if (!m_stopped) {
+            continue;
+          }
+          if (m_tasks.empty()) {
+            break;
+          }
+        }
+        task = move(m_tasks.front());
+        m_tasks.pop_front();
+        failure = m_failure;
+      }
+    }
+
+    if (replacement) {
+      replace(*self, renderer, replacement);
+      renders = 0;
+      heap = 0;
+      garbage = false;
+    } else if (collecting) {
+      if (auto runtime = RuntimeRenderer::of(*renderer)) {
+        /* Finalizers may release objects of Python. */
+        py::gil_scoped_acquire acquire;
+        runtime->collect();
+      }
+    } else if (!renderer) {
+      /* No worker has a renderer, so fail fast instead of waiting. */
+      FailingRenderer failing(failure);
+      task(failing);
+    } else {
+      task(*renderer);
+      ++renders;
+      if (self->abandoned) {
+        /* Replaced by another worker, so just wait to be joined. */
+        task = nullptr;
+        {
+          py::gil_scoped_acquire acquire;
+          renderer.reset();
+        }
+        lock_guard<mutex> lock(*m_mutex);
+        self->exited = true;
+        m_exited->notify_all();
+        return;
+      }
+      garbage = m_options.collectWhenIdle;
+      if (m_options.recycleAbove > 0) {
+        if (auto runtime = RuntimeRenderer::of(*renderer)) {
+          heap = runtime->memory().bytes;
+        }
+      }
+    }
+  }
+
+  /* Renderers are destroyed together with the pool, while holding the GIL. */
+  lock_guard<mutex> lock(*m_mutex);
+  m_retired.push_back(move(renderer));
+  self->exited = true;
+  m_exited->notify_all();
+}
+
+void RendererPool::replace(Worker &worker, unique_ptr<Renderer> &renderer,
+                           const Creator &creator) {
+  unique_ptr<Renderer> created;
+  exception_ptr error;
+  try {
+    created = creator();
+  } catch (...) {
+    error = current_exception();
+  }
+
+  {
+    /* A renderer due to be replaced isn't used anymore, even on failure. */
+    py::gil_scoped_acquire acquire;
+    renderer = move(created);
+    if (error) {
+      warn(error);
+    }
+  }
+
+  lock_guard<mutex> lock(*m_mutex);
+  if (error) {
+    fail(worker, error);
+  } else if (worker.failed) {
+    worker.failed = false;
+    worker.backoff = {};
+  }
+}
+
+void RendererPool::fail(Worker &worker, exception_ptr error) {
+  worker.failed = true;
+  worker.backoff = min(max(2 * worker.backoff, MIN_RETRY_DELAY),
+                       MAX_RETRY_DELAY);
+  worker.retryAt = chrono::steady_clock::now() + worker.backoff;
+  m_failure = move(error);
+  /* Failed workers take tasks to fail them, once all have failed. */
+  m_pending->notify_all();
+}
+
+bool RendererPool::unavailable() const {
+  return all_of(m_workers.begin(), m_workers.end(),
+                [](const auto &w) { return w->failed; });
+}
+
+bool RendererPool::recycleDue(size_t renders, size_t heap) const {
+  auto exceeds = [](size_t value, size_t limit) {
+    return limit > 0 && value >= limit;
+  };
+  if (m_stopped || m_paused ||
+      !(exceeds(renders, m_options.recycleAfter) ||
+        exceeds(heap, m_options.recycleAbove))) {
+    return false;
+  }
+  return m_tasks.empty() || exceeds(renders, 2 * m_options.recycleAfter) ||
+         exceeds(heap, 2 * m_options.recycleAbove);
+}
+
+void RendererPool::stop() {
+  {
+    lock_guard<mutex> lock(*m_mutex);
+    m_stopped = true;
+  }
+  join();
+}
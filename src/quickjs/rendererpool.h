@@ -0,0 +1,209 @@
+/**
+ * Copyright 2021 Torsten Mehnert
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+#pragma once
+
+#include <complate/core/renderer.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <variant>
+#include <vector>
+
+#include "deadline.h"
+
+/**
+ * Renderer which dispatches each render to one of several worker threads.
+ *
+ * Every worker creates its own renderer and keeps it for its lifetime, so a
+ * JavaScript runtime is never used concurrently or from a foreign thread.
+ * The GIL is released while waiting for a worker, it is only re-acquired when
+ * the view calls back into Python.
+ *
+ * With recycleAfter, a worker replaces its renderer after that many renders
+ * as soon as no task is pending, or after twice as many renders when the pool
+ * never runs idle. recycleAbove does the same for the heap of the renderer's
+ * QuickJS runtime, measured after each render. With collectWhenIdle, a worker
+ * runs the garbage collector of its renderer after a render, when no task is
+ * pending.
+ *
+ * A worker, which fails to create a renderer, drops its old one and takes no
+ * tasks until creating one succeeds. The failure is reported as
+ * RuntimeWarning and retried with a growing delay. When no worker has a
+ * renderer, tasks fail with the error of the last failure.
+ *
+ * With timeoutMs, renders are aborted at their deadline. The caller stops
+ * waiting at the deadline in any case. A worker, which doesn't return from
+ * the view by then, is abandoned and replaced by a new one, unless as many
+ * workers as the pool's size are abandoned already. Abandoned workers are
+ * joined when they return from the view, at the latest when the pool stops.
+ *
+ * A pool can be paused, to fork the process while no view is running. The
+ * workers keep their threads and renderers, so the parent resumes without
+ * rebuilding anything. The threads don't exist in the child, which resets
+ * the pool and starts new workers on the first render.
+ */
+class RendererPool : public complate::Renderer {
+public:
+  using Creator = std::function<std::unique_ptr<complate::Renderer>()>;
+  using Task = std::function<void(complate::Renderer &)>;
+
+  struct Options {
+    /** Renders after which a renderer is replaced, 0 means never. */
+    std::size_t recycleAfter = 0;
+    /** Heap bytes above which a renderer is replaced, 0 means never. */
+    std::size_t recycleAbove = 0;
+    bool collectWhenIdle = false;
+    /** Default timeout of renders in milliseconds, 0 means none. */
+    double timeoutMs = 0;
+  };
+
+  RendererPool(Creator creator, std::size_t size, Options options);
+  ~RendererPool() override;
+
+  void render(const std::string &view, const complate::Object &parameters,
+              complate::Stream &stream) override;
+  void render(const std::string &view, const std::string &parameters,
+              complate::Stream &stream) override;
+
+  /**
+   * Render on a worker with the default timeout of the pool, if any.
+   *
+   * For tasks passed to submit() or runAll(), which render on the renderer
+   * of the worker directly. A renderer interrupted by the deadline is
+   * replaced after the task.
+   */
+  void renderWithTimeout(
+      complate::Stream &stream,
+      const std::function<void(complate::Stream &)> &render) const;
+
+  /** Run a task on the next idle renderer and wait until it is done. */
+  void run(const Task &task);
+
+  /**
+   * Run tasks spread across all renderers and wait until all are done.
+   *
+   * The first error is rethrown after the remaining tasks have finished.
+   */
+  void runAll(const std::vector<Task> &tasks);
+
+  /**
+   * Queue a task for the next idle renderer and return immediately.
+   *
+   * The task must not throw and has to own everything it refers to.
+   */
+  void submit(Task task);
+
+  /**
+   * Replace all renderers by renderers of another creator.
+   *
+   * Renders already running finish on their current renderer. Idle workers
+   * replace their renderer right away, busy ones after their current task.
+   */
+  void reload(Creator creator);
+
+  /**
+   * Wait until all workers finished their current task and keep them idle.
+   *
+   * Tasks submitted meanwhile are queued until the pool is resumed. Workers
+   * abandoned at a deadline aren't waited for.
+   */
+  void pause();
+  /** Let the workers take tasks again after pause(). */
+  void resume();
+  /**
+   * Forget the workers of a paused pool in a forked child.
+   *
+   * Their threads exist only in the parent, so they are leaked together
+   * with their renderers and the queued tasks. The mutex and condition
+   * variables, which they were waiting on, are leaked and replaced as well.
+   * New workers are started by the next task.
+   */
+  void reset();
+
+  [[nodiscard]] std::size_t size() const;
+
+private:
+  struct Worker {
+    std::thread thread;
+    /** Set when the pool gave up waiting for the worker's current task. */
+    std::atomic<bool> abandoned{false};
+    /** Set when a task ran past its deadline, to replace the renderer. */
+    std::atomic<bool> poisoned{false};
+    /** Set while the worker has no renderer, since creating one failed. */
+    bool failed = false;
+    std::chrono::steady_clock::duration backoff{};
+    std::chrono::steady_clock::time_point retryAt;
+    /** Set while the worker waits for the pool to be resumed. */
+    bool paused = false;
+    bool exited = false;
+  };
+
+  using Parameters = std::variant<complate::Object, std::string>;
+  struct Pending;
+
+  /** Render on a worker, without waiting for it beyond the deadline. */
+  void renderWithin(Deadline::Clock::time_point at, const std::string &view,
+                    Parameters parameters, complate::Stream &stream);
+  /** Give up on a worker stuck in a pending render, start another one. */
+  void abandon(Worker *worker, Pending &pending);
+  /** Join abandoned workers, which have exited. Requires m_mutex. */
+  void reap();
+  /** Start the workers and wait until they created their renderers. */
+  void start();
+  void join();
+  /** Requires m_mutex to be locked. */
+  void spawn(std::promise<void> *started);
+  void work(std::shared_ptr<Worker> self, std::promise<void> *started);
+  /** Create a new renderer, the worker is out of rotation if that fails. */
+  void replace(Worker &worker, std::unique_ptr<complate::Renderer> &renderer,
+               const Creator &creator);
+  /** Requires m_mutex to be locked. */
+  void fail(Worker &worker, std::exception_ptr error);
+  /** Requires m_mutex to be locked. */
+  [[nodiscard]] bool recycleDue(std::size_t renders, std::size_t heap) const;
+  /** Whether no worker has a renderer, requires m_mutex to be locked. */
+  [[nodiscard]] bool unavailable() const;
+  void stop();
+
+  Creator m_creator;
+  const std::size_t m_size;
+  const Options m_options;
+  /* Replaced in a forked child, where the parent's workers still wait. */
+  std::unique_ptr<std::mutex> m_mutex = std::make_unique<std::mutex>();
+  std::unique_ptr<std::condition_variable> m_pending =
+      std::make_unique<std::condition_variable>();
+  std::unique_ptr<std::condition_variable> m_exited =
+      std::make_unique<std::condition_variable>();
+  std::unique_ptr<std::condition_variable> m_idle =
+      std::make_unique<std::condition_variable>();
+  std::deque<Task> m_tasks;
+  std::vector<std::shared_ptr<Worker>> m_workers;
+  std::vector<std::shared_ptr<Worker>> m_abandoned;
+  std::vector<std::unique_ptr<complate::Renderer>> m_retired;
+  std::exception_ptr m_failure;
+  std::size_t m_generation = 0;
+  bool m_stopped = false;
+  bool m_paused = false;
+};
@@ -0,0 +1,113 @@
+/**
+ * Copyright 2021 Torsten Mehnert
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+#include "renderiterator.h"
+
+#include <stdexcept>
+
+#include "asyncrender.h"
+#include "gil.h"
+
+using namespace std;
+using namespace complate;
+namespace py = pybind11;
+
+namespace {
+/* The number of chunks waiting for the consumer, before the render blocks. */
+const size_t CAPACITY = 16;
+
+template <typename Parameters>
+RendererPool::Task renderTo(const RendererPool &pool,
+                            shared_ptr<ChunkQueue> queue, string view,
+                            Parameters parameters) {
+  return [&pool, queue, view = move(view),
+          parameters = move(parameters)](Renderer &renderer) {
+    try {
+      pool.renderWithTimeout(*queue, [&](Stream &out) {
+        renderer.render(view, parameters, out);
+      });
+      queue->close(nullptr);
+    } catch (...) {
+      queue->close(current_exception());
+    }
+  };
+}
+
+void complete(const py::object &future, ChunkQueue &queue) {
+  if (future.attr("done")().cast<bool>()) {
+    return;
+  }
+  try {
+    auto chunk = queue.next();
+    if (chunk) {
+      future.attr("set_result")(py::bytes(*chunk));
+    } else {
+      future.attr("set_exception")(py::handle(PyExc_StopAsyncIteration));
+    }
+  } catch (...) {
+    AsyncRender::setException(future, current_exception());
+  }
+}
+}  // namespace
+
+RenderIterator::RenderIterator(size_t chunkSize)
+    : m_queue(make_shared<ChunkQueue>(chunkSize, CAPACITY)) {}
+
+RenderIterator::RenderIterator(RendererPool &pool, const string &view,
+                               const Object &parameters, size_t chunkSize)
+    : RenderIterator(chunkSize) {
+  pool.submit(renderTo(pool, m_queue, view, parameters));
+}
+
+RenderIterator::RenderIterator(RendererPool &pool, const string &view,
+                               const string &parameters, size_t chunkSize)
+    : RenderIterator(chunkSize) {
+  pool.submit(renderTo(pool, m_queue, view, parameters));
+}
+
+RenderIterator::~RenderIterator() {
+  if (m_queue) {
+    m_queue->cancel();
+  }
+}
+
+py::bytes RenderIterator::next() {
+  optional<string> chunk;
+  {
+    py::gil_scoped_release release;
+    chunk = m_queue->next();
+  }
+  if (!chunk) {
+    throw py::stop_iteration();
+  }
+  return py::bytes(*chunk);
+}
+
+py::object RenderIterator::anext() {
+  if (m_next && !m_next.attr("done")().cast<bool>()) {
+    throw runtime_error(
+        "anext() called while another anext() is still pending");
+  }
+  auto loop = py::module_::import("asyncio").attr("get_running_loop")();
+  auto future = loop.attr("create_future")();
+  m_next = future;
+  auto queue = m_queue;
+  auto resolve = Gil::share(py::cpp_function(
+      [queue, future]() { complete(future, *queue); }));
+  auto sharedLoop = Gil::share(loop);
+  m_queue->notify(
+      [sharedLoop, resolve]() { AsyncRender::callSoon(sharedLoop, resolve); });
+  return future;
+}
@@ -0,0 +1,47 @@
+/**
+ * Copyright 2021 Torsten Mehnert
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+#pragma once
+
+#include <pybind11/pybind11.h>
+
+#include <memory>
+
+#include "chunkqueue.h"
+#include "rendererpool.h"
+
+/**
+ * Python (async) iterator over the output of a render, which runs on a pool.
+ */
+class RenderIterator {
+public:
+  RenderIterator(RendererPool &pool, const std::string &view,
+                 const complate::Object &parameters, std::size_t chunkSize);
+  RenderIterator(RendererPool &pool, const std::string &view,
+                 const std::string &parameters, std::size_t chunkSize);
+  RenderIterator(const RenderIterator &) = delete;
+  RenderIterator(RenderIterator &&) = default;
+  ~RenderIterator();
+
+  pybind11::bytes next();
+  pybind11::object anext();
+
+private:
+  explicit RenderIterator(std::size_t chunkSize);
+
+  std::shared_ptr<ChunkQueue> m_queue;
+  /** Future of the pending anext(), only one may wait at a time. */
+  pybind11::object m_next;
+};
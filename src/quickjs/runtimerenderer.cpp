@@ -0,0 +1,172 @@
+/**
+ * Copyright 2021 Torsten Mehnert
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+#include "runtimerenderer.h"
+
+#include <stdexcept>
+
+#include "deadline.h"
+#include "renderstats.h"
+
+#ifdef COMPLATECPP_RUNTIME_HOOK
+#include <quickjs.h>
+#endif
+
+using namespace std;
+using namespace complate;
+
+#ifdef COMPLATECPP_RUNTIME_HOOK
+namespace {
+/** Options of the renderer being created on this thread, if any. */
+thread_local const RuntimeOptions *creatingOptions = nullptr;
+/** Runtime the hook created for that renderer. */
+thread_local JSRuntime *createdRuntime = nullptr;
+
+/** Makes options current for the runtimes created on this thread. */
+class Creating {
+public:
+  explicit Creating(const RuntimeOptions &options)
+      : m_options(creatingOptions), m_runtime(createdRuntime) {
+    creatingOptions = &options;
+    createdRuntime = nullptr;
+  }
+
+  ~Creating() {
+    creatingOptions = m_options;
+    createdRuntime = m_runtime;
+  }
+
+  Creating(const Creating &) = delete;
+  Creating &operator=(const Creating &) = delete;
+
+private:
+  const RuntimeOptions *m_options;
+  JSRuntime *m_runtime;
+};
+
+/** Abort the view, once the deadline of the render on this thread passed. */
+int interruptAtDeadline(JSRuntime *, void *) {
+  return Deadline::passed() ? 1 : 0;
+}
+}  // namespace
+
+extern "C" {
+JSRuntime *__real_JS_NewRuntime(void);
+
+JSRuntime *__wrap_JS_NewRuntime(void) {
+  JSRuntime *rt = __real_JS_NewRuntime();
+  if (!rt) {
+    return rt;
+  }
+  JS_SetInterruptHandler(rt, interruptAtDeadline, nullptr);
+  if (creatingOptions) {
+    if (creatingOptions->memoryLimit > 0) {
+      JS_SetMemoryLimit(rt, creatingOptions->memoryLimit);
+    }
+    if (creatingOptions->gcThreshold > 0) {
+      JS_SetGCThreshold(rt, creatingOptions->gcThreshold);
+    }
+    if (creatingOptions->maxStackSize > 0) {
+      JS_SetMaxStackSize(rt, creatingOptions->maxStackSize);
+    }
+    createdRuntime = rt;
+  }
+  return rt;
+}
+}
+#endif
+
+unique_ptr<Renderer> RuntimeRenderer::create(const Creator &creator,
+                                             const RuntimeOptions &options) {
+#ifdef COMPLATECPP_RUNTIME_HOOK
+  Creating creating(options);
+  auto renderer = creator();
+  if (!createdRuntime) {
+    throw runtime_error(
+        "The QuickJS runtime wasn't created by the runtime hook, QuickJS "
+        "must be linked statically");
+  }
+  return make_unique<RuntimeRenderer>(move(renderer), createdRuntime);
+#else
+  (void)options;
+  return creator();
+#endif
+}
+
+void RuntimeRenderer::require(const string &feature) {
+#ifndef COMPLATECPP_RUNTIME_HOOK
+  throw logic_error(feature +
+                    " requires complatecpp to be built with the runtime hook");
+#else
+  (void)feature;
+#endif
+}
+
+RuntimeRenderer *RuntimeRenderer::of(Renderer &renderer) {
+  return dynamic_cast<RuntimeRenderer *>(&renderer);
+}
+
+RuntimeRenderer::RuntimeRenderer(unique_ptr<Renderer> renderer,
+                                 JSRuntime *runtime)
+    : m_renderer(move(renderer)), m_runtime(runtime) {}
+
+void RuntimeRenderer::render(const string &view, const Object &parameters,
+                             Stream &stream) {
+  measure([&] { m_renderer->render(view, parameters, stream); });
+}
+
+void RuntimeRenderer::render(const string &view, const string &parameters,
+                             Stream &stream) {
+  measure([&] { m_renderer->render(view, parameters, stream); });
+}
+
+RuntimeRenderer::Memory RuntimeRenderer::memory() const {
+  Memory memory;
+#ifdef COMPLATECPP_RUNTIME_HOOK
+  JSMemoryUsage usage;
+  JS_ComputeMemoryUsage(m_runtime, &usage);
+  memory.bytes = static_cast<size_t>(usage.malloc_size);
+  memory.objects = static_cast<size_t>(usage.obj_count);
+#endif
+  return memory;
+}
+
+template <typename Render>
+void RuntimeRenderer::measure(const Render &render) {
+  auto stats = RenderStats::current();
+  if (!stats) {
+    render();
+    return;
+  }
+  try {
+    render();
+  } catch (...) {
+    record(*stats);
+    throw;
+  }
+  record(*stats);
+}
+
+void RuntimeRenderer::record(RenderStats &stats) const {
+  auto memory = this->memory();
+  stats.heapBytes = memory.bytes;
+  stats.heapObjects = memory.objects;
+}
+
+void RuntimeRenderer::collect() {
+#ifdef COMPLATECPP_RUNTIME_HOOK
+  JS_RunGC(m_runtime);
+#endif
+}
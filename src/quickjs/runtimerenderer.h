@@ -0,0 +1,91 @@
+/**
+ * Copyright 2021 Torsten Mehnert
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+#pragma once
+
+#include <complate/core/renderer.h>
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <string>
+
+struct JSRuntime;
+struct RenderStats;
+
+/** Settings of a QuickJS runtime, 0 keeps the default of QuickJS. */
+struct RuntimeOptions {
+  std::size_t memoryLimit = 0;
+  std::size_t gcThreshold = 0;
+  std::size_t maxStackSize = 0;
+};
+
+/**
+ * Renderer which knows the QuickJS runtime of the renderer it wraps.
+ *
+ * Instrumented renders get the heap of the runtime added to their stats.
+ *
+ * complate creates its runtimes internally and doesn't expose them. With the
+ * runtime hook, the module is linked with --wrap=JS_NewRuntime, so every
+ * runtime is created by the hook. It installs the interrupt handler, which
+ * enforces render deadlines, and configures the runtimes created while a
+ * renderer is created by create() on the same thread.
+ */
+class RuntimeRenderer : public complate::Renderer {
+public:
+  using Creator = std::function<std::unique_ptr<complate::Renderer>()>;
+
+  /** Heap of a runtime, as computed by QuickJS. */
+  struct Memory {
+    std::size_t bytes = 0;
+    std::size_t objects = 0;
+  };
+
+  /**
+   * Create a renderer, whose runtime is configured by options.
+   *
+   * Without the runtime hook, the renderer is returned as it is.
+   */
+  [[nodiscard]] static std::unique_ptr<complate::Renderer> create(
+      const Creator &creator, const RuntimeOptions &options);
+
+  /** Throw unless the module was built with the runtime hook. */
+  static void require(const std::string &feature);
+
+  /** The renderer, if it's a RuntimeRenderer, or nullptr. */
+  [[nodiscard]] static RuntimeRenderer *of(complate::Renderer &renderer);
+
+  RuntimeRenderer(std::unique_ptr<complate::Renderer> renderer,
+                  JSRuntime *runtime);
+
+  void render(const std::string &view, const complate::Object &parameters,
+              complate::Stream &stream) override;
+  void render(const std::string &view, const std::string &parameters,
+              complate::Stream &stream) override;
+
+  /** Compute the heap usage, which walks all objects of the runtime. */
+  [[nodiscard]] Memory memory() const;
+
+  /** Run the garbage collector, requires the GIL for finalizers. */
+  void collect();
+
+private:
+  template <typename Render>
+  void measure(const Render &render);
+  void record(RenderStats &stats) const;
+
+  std::unique_ptr<complate::Renderer> m_renderer;
+  JSRuntime *m_runtime;
+};
@@ -0,0 +1,30 @@
+/**
+ * Copyright 2021 Torsten Mehnert
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+#pragma once
+
+#include <string>
+
+class SourceFile {
+public:
+  SourceFile() = delete;
+
+  /**
+   * Read the views bundle from a file natively, without calling into Python.
+   *
+   * Throws a runtime_error, when the file can't be read.
+   */
+  static std::string read(const std::string &path);
+};
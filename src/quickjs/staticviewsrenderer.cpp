@@ -0,0 +1,73 @@
+/**
+ * Copyright 2021 Torsten Mehnert
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+#include "staticviewsrenderer.h"
+
+#include <complate/core/stringstream.h>
+
+using namespace std;
+using namespace complate;
+
+const char *const StaticViewsRenderer::GLOBAL = "complatecppStatic";
+
+StaticViewsRenderer::StaticViewsRenderer(unique_ptr<Renderer> renderer,
+                                         shared_ptr<const Outputs> outputs)
+    : m_renderer(move(renderer)), m_outputs(move(outputs)) {}
+
+void StaticViewsRenderer::render(const string &view, const Object &parameters,
+                                 Stream &stream) {
+  if (auto output = find(view)) {
+    stream.write(output->data(), static_cast<int>(output->size()));
+    /* Like a view does at its end. */
+    stream.flush();
+  } else {
+    m_renderer->render(view, parameters, stream);
+  }
+}
+
+void StaticViewsRenderer::render(const string &view, const string &parameters,
+                                 Stream &stream) {
+  if (auto output = find(view)) {
+    stream.write(output->data(), static_cast<int>(output->size()));
+    /* Like a view does at its end. */
+    stream.flush();
+  } else {
+    m_renderer->render(view, parameters, stream);
+  }
+}
+
+StaticViewsRenderer::Outputs StaticViewsRenderer::prerender(
+    Renderer &renderer, const map<string, Object> &views) {
+  Outputs outputs;
+  for (const auto &[view, parameters] : views) {
+    StringStream stream;
+    renderer.render(view, parameters, stream);
+    outputs.emplace(view, stream.str());
+  }
+  return outputs;
+}
+
+Object StaticViewsRenderer::fragments(const Outputs &outputs) {
+  Object fragments;
+  for (const auto &[view, output] : outputs) {
+    fragments.emplace(view, Value(output));
+  }
+  return fragments;
+}
+
+const string *StaticViewsRenderer::find(const string &view) const {
+  auto it = m_outputs->find(view);
+  return it != m_outputs->end() ? &it->second : nullptr;
+}
@@ -0,0 +1,61 @@
+/**
+ * Copyright 2021 Torsten Mehnert
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+#pragma once
+
+#include <complate/core/renderer.h>
+#include <complate/core/value.h>
+
+#include <map>
+#include <memory>
+#include <string>
+
+/**
+ * Renderer which writes pre-rendered output for static views.
+ *
+ * Views that don't depend on their parameters are rendered once, when the
+ * renderer is built. Afterwards their output is written to the stream as it
+ * is, without running any JavaScript. All other views are rendered as usual.
+ * They may splice the output into their own, it's exposed to them as global.
+ */
+class StaticViewsRenderer : public complate::Renderer {
+public:
+  using Outputs = std::map<std::string, std::string>;
+
+  StaticViewsRenderer(std::unique_ptr<complate::Renderer> renderer,
+                      std::shared_ptr<const Outputs> outputs);
+
+  void render(const std::string &view, const complate::Object &parameters,
+              complate::Stream &stream) override;
+  void render(const std::string &view, const std::string &parameters,
+              complate::Stream &stream) override;
+
+  /** Name of the global object holding the output of each static view. */
+  static const char *const GLOBAL;
+
+  /** The global, strings of raw HTML by the names of the views. */
+  [[nodiscard]] static complate::Object fragments(const Outputs &outputs);
+
+  /** Render each of the views once, with the parameters given for it. */
+  [[nodiscard]] static Outputs prerender(
+      complate::Renderer &renderer,
+      const std::map<std::string, complate::Object> &views);
+
+private:
+  [[nodiscard]] const std::string *find(const std::string &view) const;
+
+  std::unique_ptr<complate::Renderer> m_renderer;
+  std::shared_ptr<const Outputs> m_outputs;
+};
@@ -0,0 +1,90 @@
+/**
+ * Copyright 2021 Torsten Mehnert
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+#include "batch.h"
+
+#include <stdexcept>
+
+#include "mapper.h"
+#include "outputstream.h"
+
+using namespace std;
+using namespace complate;
+namespace py = pybind11;
+
+Batch::Batch(const py::iterable &items, bool lazy) {
+  for (const auto &item : items) {
+    auto pair = py::reinterpret_borrow<py::sequence>(item);
+    if (pair.size() != 2) {
+      throw invalid_argument(
+          "A batch item must be a pair of view and parameters");
+    }
+    py::object view = pair[0];
+    py::object parameters = pair[1];
+    if (py::isinstance<py::dict>(parameters)) {
+      m_items.push_back(
+          {view.cast<string>(),
+           Mapper::python_to_object(parameters.cast<py::dict>(), lazy)});
+    } else if (py::isinstance<py::str>(parameters)) {
+      m_items.push_back({view.cast<string>(), parameters.cast<string>()});
+    } else {
+      m_items.push_back(
+          {view.cast<string>(), Mapper::buffer_to_string(parameters)});
+    }
+  }
+  m_outputs.resize(m_items.size());
+}
+
+string Batch::render(Renderer &renderer, size_t index) const {
+  OutputStream stream;
+  render(renderer, index, stream);
+  return stream.take();
+}
+
+void Batch::render(Renderer &renderer, size_t index, Stream &stream) const {
+  const auto &item = m_items[index];
+  visit(
+      [&](const auto &parameters) {
+        renderer.render(item.view, parameters, stream);
+      },
+      item.parameters);
+}
+
+void Batch::render(Renderer &renderer) {
+  for (size_t i = 0; i < m_items.size(); ++i) {
+    m_outputs[i] = render(renderer, i);
+  }
+}
+
+py::list Batch::outputs(bool asBytes) const {
+  py::list list(m_outputs.size());
+  for (size_t i = 0; i < m_outputs.size(); ++i) {
+    const auto &output = m_outputs[i];
+    PyObject *obj =
+        asBytes ? PyBytes_FromStringAndSize(output.data(), output.size())
+                : PyUnicode_DecodeUTF8(output.data(), output.size(), nullptr);
+    if (!obj) {
+      throw py::error_already_set();
+    }
+    PyList_SET_ITEM(list.ptr(), i, obj);
+  }
+  return list;
+}
+
+size_t Batch::size() const { return m_items.size(); }
+
+void Batch::set(size_t index, string output) {
+  m_outputs[index] = move(output);
+}
@@ -0,0 +1,60 @@
+/**
+ * Copyright 2021 Torsten Mehnert
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+#pragma once
+
+#include <complate/core/renderer.h>
+#include <pybind11/pybind11.h>
+
+#include <string>
+#include <variant>
+#include <vector>
+
+/** Several renders of a single render_batch call. */
+class Batch {
+public:
+  struct Item {
+    std::string view;
+    std::variant<complate::Object, std::string> parameters;
+  };
+
+  /**
+   * Convert (view, parameters) pairs, parameters are a dict or JSON.
+   *
+   * All items are converted before the first render, so the renders don't
+   * need the GIL unless the views call back into Python.
+   */
+  Batch(const pybind11::iterable &items, bool lazy);
+
+  /** Render the item at index to a string. */
+  [[nodiscard]] std::string render(complate::Renderer &renderer,
+                                   std::size_t index) const;
+  /** Render the item at index to a stream. */
+  void render(complate::Renderer &renderer, std::size_t index,
+              complate::Stream &stream) const;
+
+  /** Render all items one after another. */
+  void render(complate::Renderer &renderer);
+
+  /** Hand over the outputs as list of str, or bytes when asBytes is set. */
+  [[nodiscard]] pybind11::list outputs(bool asBytes) const;
+
+  [[nodiscard]] std::size_t size() const;
+  void set(std::size_t index, std::string output);
+
+private:
+  std::vector<Item> m_items;
+  std::vector<std::string> m_outputs;
+};
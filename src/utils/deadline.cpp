@@ -0,0 +1,93 @@
+/**
+ * Copyright 2021 Torsten Mehnert
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+#include "deadline.h"
+
+using namespace std;
+namespace py = pybind11;
+
+Deadline::State &Deadline::current() { return ThreadState::current().deadline; }
+
+optional<Deadline::Clock::time_point> Deadline::after(double timeoutMs) {
+  if (timeoutMs <= 0) {
+    return nullopt;
+  }
+  return Clock::now() + chrono::duration_cast<Clock::duration>(
+                            chrono::duration<double, milli>(timeoutMs));
+}
+
+void Deadline::check() {
+  const auto &state = current();
+  if (state.at && Clock::now() >= *state.at) {
+    expire();
+  }
+}
+
+bool Deadline::passed() noexcept {
+  auto &state = current();
+  if (state.at && Clock::now() >= *state.at) {
+    state.expired = true;
+    return true;
+  }
+  return false;
+}
+
+void Deadline::expire() {
+  current().expired = true;
+  throw RenderTimeout("The render exceeded its deadline");
+}
+
+Deadline::Scope::Scope(optional<Clock::time_point> at)
+    : m_previous(current()), m_active(at.has_value()) {
+  if (m_active) {
+    current() = {at, false};
+  }
+}
+
+Deadline::Scope::~Scope() {
+  if (m_active) {
+    current() = m_previous;
+  }
+}
+
+Deadline::Lift::Lift() : m_previous(current()) { current() = {}; }
+
+Deadline::Lift::~Lift() { current() = m_previous; }
+
+void Deadline::registerTranslator() {
+  py::register_exception_translator([](exception_ptr p) {
+    try {
+      if (p) {
+        rethrow_exception(p);
+      }
+    } catch (const RenderTimeout &e) {
+      PyErr_SetString(PyExc_TimeoutError, e.what());
+    }
+  });
+}
+
+DeadlineStream::DeadlineStream(complate::Stream &stream) : m_stream(stream) {}
+
+void DeadlineStream::write(const char *str, int len) {
+  Deadline::check();
+  m_stream.write(str, len);
+}
+
+void DeadlineStream::writeln(const char *str, int len) {
+  Deadline::check();
+  m_stream.writeln(str, len);
+}
+
+void DeadlineStream::flush() { m_stream.flush(); }
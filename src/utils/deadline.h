@@ -0,0 +1,124 @@
+/**
+ * Copyright 2021 Torsten Mehnert
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+#pragma once
+
+#include <complate/core/stream.h>
+#include <pybind11/pybind11.h>
+
+#include <chrono>
+#include <optional>
+#include <stdexcept>
+
+#include "threadstate.h"
+
+/** Thrown when a render exceeded its deadline, a TimeoutError in Python. */
+class RenderTimeout : public std::runtime_error {
+public:
+  using std::runtime_error::runtime_error;
+};
+
+/**
+ * Deadline of the render running on this thread.
+ *
+ * Calls into Python and writes to the stream check the deadline and throw,
+ * once it has passed. Where the linker allows it, the interrupt handler of
+ * every QuickJS runtime checks it as well, which stops views running plain
+ * JavaScript. The deadline is part of the ThreadState, which all extension
+ * modules share.
+ */
+class Deadline {
+public:
+  using Clock = std::chrono::steady_clock;
+
+  using State = ThreadState::Deadline;
+
+  [[nodiscard]] static State &current();
+
+  /** The point in time timeoutMs from now, none for 0. */
+  [[nodiscard]] static std::optional<Clock::time_point> after(
+      double timeoutMs);
+
+  /** Throw RenderTimeout, when the deadline of this thread has passed. */
+  static void check();
+
+  /** Mark the deadline of this thread as expired and throw. */
+  [[noreturn]] static void expire();
+
+  /**
+   * Render with a deadline, a failure caused by an expired deadline is
+   * rethrown as RenderTimeout.
+   */
+  template <typename Render>
+  static void run(std::optional<Clock::time_point> at, const Render &render) {
+    Scope scope(at);
+    try {
+      render();
+    } catch (...) {
+      if (current().expired) {
+        expire();
+      }
+      throw;
+    }
+  }
+
+  /**
+   * Whether the deadline of this thread has passed, marks it expired if so.
+   *
+   * Never throws, so it's usable from the QuickJS interrupt handler.
+   */
+  [[nodiscard]] static bool passed() noexcept;
+
+  /** Makes a deadline current, none keeps the deadline of the caller. */
+  class Scope {
+  public:
+    explicit Scope(std::optional<Clock::time_point> at);
+    ~Scope();
+    Scope(const Scope &) = delete;
+    Scope &operator=(const Scope &) = delete;
+
+  private:
+    State m_previous;
+    bool m_active;
+  };
+
+  /** Lifts the deadline of this thread, to write output rendered in time. */
+  class Lift {
+  public:
+    Lift();
+    ~Lift();
+    Lift(const Lift &) = delete;
+    Lift &operator=(const Lift &) = delete;
+
+  private:
+    State m_previous;
+  };
+
+  /** Translate RenderTimeout into TimeoutError. */
+  static void registerTranslator();
+};
+
+/** Checks the deadline of the current thread before every write. */
+class DeadlineStream : public complate::Stream {
+public:
+  explicit DeadlineStream(complate::Stream &stream);
+
+  void write(const char *str, int len) override;
+  void writeln(const char *str, int len) override;
+  void flush() override;
+
+private:
+  complate::Stream &m_stream;
+};
@@ -0,0 +1,42 @@
+/**
+ * Copyright 2021 Torsten Mehnert
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+#pragma once
+
+#include <pybind11/pybind11.h>
+
+#include <memory>
+
+class Gil {
+public:
+  Gil() = delete;
+
+  /**
+   * Share a Python object with the JavaScript engine.
+   *
+   * The returned pointer may be released from any thread, the GIL is acquired
+   * when the last reference goes away.
+   */
+  static std::shared_ptr<pybind11::object> share(const pybind11::object &obj);
+
+  /** Create an object holding Python references, to share it the same way. */
+  template <typename T, typename... Args>
+  static std::shared_ptr<T> make_shared(Args &&...args) {
+    return std::shared_ptr<T>(new T(std::forward<Args>(args)...), [](T *p) {
+      pybind11::gil_scoped_acquire acquire;
+      delete p;
+    });
+  }
+};
@@ -0,0 +1,362 @@
+/**
+ * Copyright 2021 Torsten Mehnert
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+#include "jsonwriter.h"
+
+#include <cmath>
+
+using namespace std;
+namespace py = pybind11;
+
+namespace {
+const char HEX[] = "0123456789abcdef";
+
+/* Larger buffers are released after use, instead of being kept. */
+const size_t MAX_RETAINED = 4 * 1024 * 1024;
+
+thread_local string threadBuffer;
+thread_local bool threadBufferInUse = false;
+
+/**
+ * Names of the public attributes of a type, looked up once per type.
+ *
+ * Entries are keyed by the address of the type and hold a weak reference to
+ * it, which drops the entry when the type is destroyed. Classes created at
+ * runtime are neither kept alive nor pile up this way.
+ */
+py::list attributes(PyObject *type) {
+  /* Leaked, to not outlive the interpreter on exit. */
+  static auto cache = new py::dict();
+  auto key = py::reinterpret_steal<py::object>(PyLong_FromVoidPtr(type));
+  if (!key) {
+    throw py::error_already_set();
+  }
+  if (PyObject *entry = PyDict_GetItem(cache->ptr(), key.ptr())) {
+    return py::reinterpret_borrow<py::tuple>(entry)[1];
+  }
+
+  py::list names;
+  auto cls = py::reinterpret_borrow<py::object>(type);
+  auto fields = py::getattr(cls, "__dataclass_fields__", py::none());
+  if (!fields.is_none()) {
+    for (auto name : fields.cast<py::dict>()) {
+      names.append(name.first);
+    }
+  } else {
+    auto property = py::module_::import("builtins").attr("property");
+    for (auto base : cls.attr("__mro__")) {
+      auto slots = py::getattr(base, "__slots__", py::tuple());
+      if (py::isinstance<py::str>(slots)) {
+        slots = py::make_tuple(slots);
+      }
+      for (auto slot : slots) {
+        names.append(slot);
+      }
+      for (auto item : base.attr("__dict__").cast<py::dict>()) {
+        if (py::isinstance(item.second, property)) {
+          names.append(item.first);
+        }
+      }
+    }
+  }
+
+  py::list visible;
+  for (auto name : names) {
+    auto str = name.cast<string>();
+    if (str.empty() || str[0] == '_' || visible.contains(name)) {
+      continue;
+    }
+    visible.append(name);
+  }
+  auto drop = py::cpp_function([key](const py::handle &) {
+    if (PyDict_DelItem(cache->ptr(), key.ptr()) < 0) {
+      PyErr_Clear();
+    }
+  });
+  (*cache)[key] = py::make_tuple(py::weakref(type, drop), visible);
+  return visible;
+}
+
+py::type_error unsupported(PyObject *obj) {
+  return py::type_error(string("Object of type ") + Py_TYPE(obj)->tp_name +
+                        " is not serializable as view parameters");
+}
+}  // namespace
+
+string JsonWriter::dumps(const py::handle &obj) {
+  string out;
+  dumps(obj, out);
+  return out;
+}
+
+void JsonWriter::dumps(const py::handle &obj, string &out) {
+  JsonWriter writer(out);
+  writer.write(obj.ptr());
+}
+
+JsonWriter::JsonWriter(string &out) : m_out(out) {}
+
+void JsonWriter::write(PyObject *obj) {
+  if (obj == Py_None) {
+    m_out.append("null");
+  } else if (obj == Py_True) {
+    m_out.append("true");
+  } else if (obj == Py_False) {
+    m_out.append("false");
+  } else if (PyUnicode_Check(obj)) {
+    writeString(obj);
+  } else if (PyLong_Check(obj)) {
+    writeLong(obj);
+  } else if (PyFloat_Check(obj)) {
+    writeFloat(obj);
+  } else {
+    if (Py_EnterRecursiveCall(" while serializing view parameters")) {
+      throw py::error_already_set();
+    }
+    struct Leave {
+      ~Leave() { Py_LeaveRecursiveCall(); }
+    } leave;
+
+    if (PyDict_Check(obj)) {
+      m_out.push_back('{');
+      PyObject *key, *value;
+      Py_ssize_t pos = 0;
+      bool first = true;
+      while (PyDict_Next(obj, &pos, &key, &value)) {
+        if (!first) {
+          m_out.push_back(',');
+        }
+        first = false;
+        writeKey(key);
+        write(value);
+      }
+      m_out.push_back('}');
+    } else if (PyList_Check(obj) || PyTuple_Check(obj)) {
+      auto seq = py::reinterpret_borrow<py::sequence>(obj);
+      m_out.push_back('[');
+      for (size_t i = 0; i < seq.size(); ++i) {
+        if (i) {
+          m_out.push_back(',');
+        }
+        write(PySequence_Fast_GET_ITEM(obj, i));
+      }
+      m_out.push_back(']');
+    } else {
+      writeAttributes(obj);
+    }
+  }
+}
+
+void JsonWriter::writeString(PyObject *str) {
+  Py_ssize_t size;
+  const char *data = PyUnicode_AsUTF8AndSize(str, &size);
+  if (!data) {
+    if (!PyErr_ExceptionMatches(PyExc_UnicodeEncodeError)) {
+      throw py::error_already_set();
+    }
+    PyErr_Clear();
+    writeSurrogates(str);
+    return;
+  }
+  m_out.reserve(m_out.size() + size + 2);
+  m_out.push_back('"');
+  writeCharacters(data, size);
+  m_out.push_back('"');
+}
+
+void JsonWriter::writeSurrogates(PyObject *str) {
+  /* Lone surrogates have no UTF-8 encoding, so they are escaped as \uXXXX
+   * like json.dumps does. */
+  m_out.push_back('"');
+  auto length = PyUnicode_GET_LENGTH(str);
+  Py_ssize_t start = 0;
+  for (Py_ssize_t i = 0; i <= length; ++i) {
+    Py_UCS4 c = i < length ? PyUnicode_READ_CHAR(str, i) : 0;
+    if (i < length && !Py_UNICODE_IS_SURROGATE(c)) {
+      continue;
+    }
+    if (i > start) {
+      auto part = py::reinterpret_steal<py::object>(
+          PyUnicode_Substring(str, start, i));
+      Py_ssize_t size;
+      const char *data =
+          part ? PyUnicode_AsUTF8AndSize(part.ptr(), &size) : nullptr;
+      if (!data) {
+        throw py::error_already_set();
+      }
+      writeCharacters(data, size);
+    }
+    if (i < length) {
+      m_out.append("\\u");
+      for (int shift = 12; shift >= 0; shift -= 4) {
+        m_out.push_back(HEX[(c >> shift) & 0xf]);
+      }
+    }
+    start = i + 1;
+  }
+  m_out.push_back('"');
+}
+
+void JsonWriter::writeCharacters(const char *data, Py_ssize_t size) {
+  for (Py_ssize_t i = 0; i < size; ++i) {
+    auto c = static_cast<unsigned char>(data[i]);
+    switch (c) {
+      case '"':
+        m_out.append("\\\"");
+        break;
+      case '\\':
+        m_out.append("\\\\");
+        break;
+      case '\n':
+        m_out.append("\\n");
+        break;
+      case '\r':
+        m_out.append("\\r");
+        break;
+      case '\t':
+        m_out.append("\\t");
+        break;
+      default:
+        if (c < 0x20) {
+          m_out.append("\\u00");
+          m_out.push_back(HEX[c >> 4]);
+          m_out.push_back(HEX[c & 0xf]);
+        } else {
+          m_out.push_back(static_cast<char>(c));
+        }
+    }
+  }
+}
+
+void JsonWriter::writeLong(PyObject *obj) {
+  /* Like int.__repr__, also for subclasses such as IntEnum. */
+  auto str = py::reinterpret_steal<py::object>(PyLong_Type.tp_repr(obj));
+  if (!str) {
+    throw py::error_already_set();
+  }
+  m_out.append(PyUnicode_AsUTF8(str.ptr()));
+}
+
+void JsonWriter::writeFloat(PyObject *obj) {
+  double value = PyFloat_AS_DOUBLE(obj);
+  if (!std::isfinite(value)) {
+    throw py::value_error(
+        "Out of range float values are not JSON compliant");
+  }
+  char *str = PyOS_double_to_string(value, 'r', 0, 0, nullptr);
+  if (!str) {
+    throw py::error_already_set();
+  }
+  m_out.append(str);
+  PyMem_Free(str);
+}
+
+void JsonWriter::writeKey(PyObject *key) {
+  if (PyUnicode_Check(key)) {
+    writeString(key);
+    m_out.push_back(':');
+    return;
+  }
+  /* Other keys are converted like json.dumps does. */
+  m_out.push_back('"');
+  if (key == Py_True) {
+    m_out.append("true");
+  } else if (key == Py_False) {
+    m_out.append("false");
+  } else if (key == Py_None) {
+    m_out.append("null");
+  } else if (PyLong_Check(key)) {
+    writeLong(key);
+  } else if (PyFloat_Check(key)) {
+    double value = PyFloat_AS_DOUBLE(key);
+    if (std::isnan(value)) {
+      m_out.append("NaN");
+    } else if (std::isinf(value)) {
+      m_out.append(value < 0 ? "-Infinity" : "Infinity");
+    } else {
+      writeFloat(key);
+    }
+  } else {
+    throw py::type_error(
+        string("keys must be str, int, float, bool or None, not ") +
+        Py_TYPE(key)->tp_name);
+  }
+  m_out.append("\":");
+}
+
+void JsonWriter::writeAttributes(PyObject *obj) {
+  auto names = attributes(reinterpret_cast<PyObject *>(Py_TYPE(obj)));
+  auto handle = py::handle(obj);
+  if (PyCallable_Check(obj) ||
+      (names.empty() && !py::hasattr(handle, "__dict__"))) {
+    throw unsupported(obj);
+  }
+  py::dict instance = py::getattr(handle, "__dict__", py::dict());
+
+  m_out.push_back('{');
+  bool first = true;
+  auto member = [&](const py::handle &name, const py::object &value) {
+    if (!first) {
+      m_out.push_back(',');
+    }
+    first = false;
+    writeKey(name.ptr());
+    write(value.ptr());
+  };
+  for (auto name : names) {
+    if (py::hasattr(handle, name)) {
+      member(name, handle.attr(name));
+    }
+  }
+  for (auto item : instance) {
+    auto key = item.first.cast<string>();
+    if (!key.empty() && key[0] != '_' && !names.contains(item.first)) {
+      member(item.first, py::reinterpret_borrow<py::object>(item.second));
+    }
+  }
+  /* Like enum members, which only have private attributes. */
+  if (first && !py::hasattr(handle, "__dataclass_fields__")) {
+    throw unsupported(obj);
+  }
+  m_out.push_back('}');
+}
+
+JsonBuffer::JsonBuffer(const py::handle &obj)
+    : m_buffer(&m_local), m_shared(!threadBufferInUse) {
+  if (m_shared) {
+    m_buffer = &threadBuffer;
+    threadBufferInUse = true;
+    m_buffer->clear();
+  }
+  try {
+    JsonWriter::dumps(obj, *m_buffer);
+  } catch (...) {
+    if (m_shared) {
+      threadBufferInUse = false;
+    }
+    throw;
+  }
+}
+
+JsonBuffer::~JsonBuffer() {
+  if (m_shared) {
+    if (threadBuffer.capacity() > MAX_RETAINED) {
+      string().swap(threadBuffer);
+    }
+    threadBufferInUse = false;
+  }
+}
+
+const string &JsonBuffer::str() const { return *m_buffer; }
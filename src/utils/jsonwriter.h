@@ -0,0 +1,71 @@
+/**
+ * Copyright 2021 Torsten Mehnert
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+#pragma once
+
+#include <pybind11/pybind11.h>
+
+#include <string>
+
+/**
+ * Serializes view parameters to JSON without going through the json module.
+ *
+ * Besides dicts, lists, tuples and scalars, it writes objects of dataclasses
+ * and of classes with __slots__, properties or plain attributes as objects
+ * containing their public attributes. Objects without any, like members of
+ * enums, raise a TypeError. Keys of dicts are converted like json.dumps does.
+ */
+class JsonWriter {
+public:
+  static std::string dumps(const pybind11::handle &obj);
+  /** Append the JSON of obj to out. */
+  static void dumps(const pybind11::handle &obj, std::string &out);
+
+private:
+  explicit JsonWriter(std::string &out);
+
+  void write(PyObject *obj);
+  void writeString(PyObject *str);
+  void writeSurrogates(PyObject *str);
+  void writeCharacters(const char *data, Py_ssize_t size);
+  void writeLong(PyObject *obj);
+  void writeFloat(PyObject *obj);
+  void writeKey(PyObject *key);
+  void writeAttributes(PyObject *obj);
+
+  std::string &m_out;
+};
+
+/**
+ * JSON of view parameters written to a buffer, which is reused per thread.
+ *
+ * The buffer keeps its capacity between renders, so converting parameters
+ * this way doesn't allocate once it has grown large enough. Nested renders
+ * on the same thread fall back to a buffer of their own.
+ */
+class JsonBuffer {
+public:
+  explicit JsonBuffer(const pybind11::handle &obj);
+  ~JsonBuffer();
+  JsonBuffer(const JsonBuffer &) = delete;
+  JsonBuffer &operator=(const JsonBuffer &) = delete;
+
+  [[nodiscard]] const std::string &str() const;
+
+private:
+  std::string m_local;
+  std::string *m_buffer;
+  bool m_shared;
+};
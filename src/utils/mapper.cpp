@@ -15,72 +15,267 @@
  */
 #include "mapper.h"
 
+#include "deadline.h"
+#include "gil.h"
+#include "renderstats.h"
+#include "threadstate.h"
+
+#include <stdexcept>
+#include <thread>
+
 using namespace std;
 using namespace complate;
 namespace py = pybind11;
 
-py::object Mapper::value_to_python(const Value& value) {
+const char *const Mapper::LAZY_DICT = "complatecpp.LazyDict";
+const char *const Mapper::LAZY_MARKER = "__complatecppLazy";
+const char *const Mapper::FROZEN = "complatecpp.Frozen";
+
+namespace {
+/** Only the owner writes alive, so it's read after the owner was checked. */
+void ensureAlive(const shared_ptr<ThreadState::Liveness> &token) {
+  if (token && (token->owner != this_thread::get_id() || !token->alive)) {
+    throw runtime_error(
+        "A JavaScript function is only callable on the thread of its view, "
+        "while the call from the view into Python that passed it runs");
+  }
+}
+
+string utf8(PyObject *str) {
+  Py_ssize_t size;
+  const char *data = PyUnicode_AsUTF8AndSize(str, &size);
+  if (!data) {
+    throw py::error_already_set();
+  }
+  return string(data, size);
+}
+
+Value number(PyObject *obj) {
+  int overflow;
+  auto number = PyLong_AsLongLongAndOverflow(obj, &overflow);
+  if (overflow) {
+    /* Raises an OverflowError beyond the range of a double. */
+    auto value = PyLong_AsDouble(obj);
+    if (value == -1.0 && PyErr_Occurred()) {
+      throw py::error_already_set();
+    }
+    return Value(value);
+  }
+  if (number == -1 && PyErr_Occurred()) {
+    throw py::error_already_set();
+  }
+  return Value(static_cast<int64_t>(number));
+}
+
+Value lazyDict(const py::handle &obj) {
+  auto pptr = Gil::share(py::reinterpret_borrow<py::object>(obj));
+  return Value(Proxy(Mapper::LAZY_DICT, pptr));
+}
+
+Value fallback(const py::handle &obj, bool lazy) {
+  if (py::isinstance<Value>(obj)) {
+    return obj.cast<Value>();
+  }
+  if (py::isinstance<py::str>(obj)) {
+    return Value(utf8(obj.ptr()));
+  }
+  if (py::isinstance<py::bool_>(obj)) {
+    return Value(py::cast<bool>(obj));
+  }
+  if (py::isinstance<py::int_>(obj)) {
+    return number(obj.ptr());
+  }
+  if (py::isinstance<py::float_>(obj)) {
+    return Value(py::cast<double>(obj));
+  }
+  if (py::isinstance<py::list>(obj) || py::isinstance<py::tuple>(obj)) {
+    Array array;
+    array.reserve(py::len(obj));
+    for (auto item : obj) {
+      array.emplace_back(Mapper::python_to_value(item, lazy));
+    }
+    return Value(move(array));
+  }
+  if (py::isinstance<py::dict>(obj)) {
+    if (lazy) {
+      return lazyDict(obj);
+    }
+    return Value(Mapper::python_to_object(obj.cast<py::dict>()));
+  }
+  if (py::isinstance<py::function>(obj)) {
+    auto fptr = Gil::share(py::reinterpret_borrow<py::object>(obj));
+    return Value(Function([fptr](const Array &args) -> Value {
+      Deadline::check();
+      RenderStats::Callback timing;
+      Mapper::Call fromView;
+      py::gil_scoped_acquire acquire;
+      auto tup = Mapper::args_to_tuple(args);
+      return Mapper::python_to_value((*fptr)(*tup));
+    }));
+  }
+  auto name = obj.attr("__class__").attr("__name__").cast<string>();
+  auto pptr = Gil::share(py::reinterpret_borrow<py::object>(obj));
+  return Value(Proxy(name, pptr));
+}
+}  // namespace
+
+Mapper::Call::Call() {
+  auto &state = ThreadState::current();
+  if (state.calls++ == 0) {
+    state.liveness = make_shared<ThreadState::Liveness>();
+  }
+}
+
+Mapper::Call::~Call() {
+  auto &state = ThreadState::current();
+  if (--state.calls == 0) {
+    state.liveness->alive = false;
+    state.liveness.reset();
+  }
+}
+
+Value Mapper::python_to_value(const py::handle &obj, bool lazy) {
+  PyObject *ptr = obj.ptr();
+  if (ptr == Py_None) {
+    return Value(nullptr);
+  }
+  if (PyUnicode_CheckExact(ptr)) {
+    return Value(utf8(ptr));
+  }
+  if (PyBool_Check(ptr)) {
+    return Value(ptr == Py_True);
+  }
+  if (PyLong_CheckExact(ptr)) {
+    return number(ptr);
+  }
+  if (PyFloat_CheckExact(ptr)) {
+    return Value(PyFloat_AS_DOUBLE(ptr));
+  }
+  if (PyDict_CheckExact(ptr)) {
+    if (lazy) {
+      return lazyDict(obj);
+    }
+    return Value(python_to_object(py::reinterpret_borrow<py::dict>(obj)));
+  }
+  if (PyList_CheckExact(ptr)) {
+    auto size = PyList_GET_SIZE(ptr);
+    Array array;
+    array.reserve(size);
+    for (Py_ssize_t i = 0; i < size; ++i) {
+      array.emplace_back(python_to_value(PyList_GET_ITEM(ptr, i), lazy));
+    }
+    return Value(move(array));
+  }
+  if (PyTuple_CheckExact(ptr)) {
+    auto size = PyTuple_GET_SIZE(ptr);
+    Array array;
+    array.reserve(size);
+    for (Py_ssize_t i = 0; i < size; ++i) {
+      array.emplace_back(python_to_value(PyTuple_GET_ITEM(ptr, i), lazy));
+    }
+    return Value(move(array));
+  }
+  return fallback(obj, lazy);
+}
+
+Object Mapper::python_to_object(const py::dict &dict, bool lazy) {
+  Object object;
+  PyObject *key;
+  PyObject *value;
+  Py_ssize_t pos = 0;
+  while (PyDict_Next(dict.ptr(), &pos, &key, &value)) {
+    auto name = PyUnicode_Check(key) ? utf8(key)
+                                     : py::str(py::handle(key)).cast<string>();
+    object.emplace(move(name), python_to_value(value, lazy));
+  }
+  if (lazy) {
+    object.emplace(LAZY_MARKER, Value(true));
+  }
+  return object;
+}
+
+py::object Mapper::value_to_python(const Value &value) {
   if (value.holds<Null>()) {
-    return py::cast(value.exactly<Null>());
+    return py::none();
   } else if (value.holds<Bool>()) {
-    return py::cast(value.exactly<Bool>());
+    return py::bool_(value.exactly<Bool>());
   } else if (value.holds<Number>()) {
-    const auto& number = value.exactly<Number>();
+    const auto &number = value.exactly<Number>();
     if (number.holds<int32_t>()) {
-      return py::cast(number.exactly<int32_t>());
+      return py::int_(number.exactly<int32_t>());
     } else if (number.holds<uint32_t>()) {
-      return py::cast(number.exactly<uint32_t>());
+      return py::int_(number.exactly<uint32_t>());
     } else if (number.holds<int64_t>()) {
-      return py::cast(number.exactly<int64_t>());
+      return py::int_(number.exactly<int64_t>());
     } else if (number.holds<double>()) {
-      return py::cast(number.exactly<double>());
+      return py::float_(number.exactly<double>());
     }
   } else if (value.holds<String>()) {
-    return py::cast(value.exactly<String>().get<string>());
+    const auto str = value.exactly<String>().get<string>();
+    return py::str(str.data(), str.size());
+  } else if (value.holds<Array>()) {
+    const auto &array = value.exactly<Array>();
+    py::list list(array.size());
+    for (size_t i = 0; i < array.size(); ++i) {
+      PyList_SET_ITEM(list.ptr(), i, value_to_python(array[i]).release().ptr());
+    }
+    return list;
+  } else if (value.holds<Object>()) {
+    py::dict dict;
+    for (const auto &[key, member] : value.exactly<Object>()) {
+      dict[py::str(key.data(), key.size())] = value_to_python(member);
+    }
+    return dict;
+  } else if (value.holds<Function>()) {
+    auto function = value.exactly<Function>();
+    /* Functions converted outside of any view stay callable. */
+    auto token = ThreadState::current().liveness;
+    return py::cpp_function([function, token](const py::args &args) {
+      ensureAlive(token);
+      Array array;
+      array.reserve(args.size());
+      for (auto arg : args) {
+        array.emplace_back(python_to_value(arg));
+      }
+      return value_to_python(function.apply(array));
+    });
+  } else if (value.holds<Proxy>()) {
+    const auto &proxy = value.exactly<Proxy>();
+    if (proxy.name() == FROZEN) {
+      auto node = static_cast<const FrozenNode *>(proxy.ptr().get());
+      return value_to_python(Value(*node->object));
+    }
+    /* Other proxies have been created from a Python object by this module. */
+    return *static_cast<py::object *>(proxy.ptr().get());
   }
 
   return py::none();
 }
 
-py::tuple Mapper::args_to_tuple(const Array& args) {
-  if (args.empty()) {
-    return py::make_tuple();
-  } else if (args.size() == 1) {
-    return py::make_tuple(value_to_python(args.at(0)));
-  } else if (args.size() == 2) {
-    return py::make_tuple(value_to_python(args.at(0)),
-                          value_to_python(args.at(1)));
-  } else if (args.size() == 3) {
-    return py::make_tuple(value_to_python(args.at(0)),
-                          value_to_python(args.at(1)),
-                          value_to_python(args.at(2)));
-  } else if (args.size() == 4) {
-    return py::make_tuple(
-        value_to_python(args.at(0)), value_to_python(args.at(1)),
-        value_to_python(args.at(2)), value_to_python(args.at(3)));
-  } else if (args.size() == 5) {
-    return py::make_tuple(
-        value_to_python(args.at(0)), value_to_python(args.at(1)),
-        value_to_python(args.at(2)), value_to_python(args.at(3)),
-        value_to_python(args.at(4)));
-  } else if (args.size() == 6) {
-    return py::make_tuple(
-        value_to_python(args.at(0)), value_to_python(args.at(1)),
-        value_to_python(args.at(2)), value_to_python(args.at(3)),
-        value_to_python(args.at(4)), value_to_python(args.at(5)));
-  } else if (args.size() == 7) {
-    return py::make_tuple(
-        value_to_python(args.at(0)), value_to_python(args.at(1)),
-        value_to_python(args.at(2)), value_to_python(args.at(3)),
-        value_to_python(args.at(4)), value_to_python(args.at(5)),
-        value_to_python(args.at(6)));
-  } else if (args.size() == 8) {
-    return py::make_tuple(
-        value_to_python(args.at(0)), value_to_python(args.at(1)),
-        value_to_python(args.at(2)), value_to_python(args.at(3)),
-        value_to_python(args.at(4)), value_to_python(args.at(5)),
-        value_to_python(args.at(6)), value_to_python(args.at(7)));
-  } else {
-    throw invalid_argument("More then 8 arguments are not supported");
+string Mapper::buffer_to_string(const py::buffer &buffer) {
+  Py_buffer view;
+  if (PyObject_GetBuffer(buffer.ptr(), &view, PyBUF_SIMPLE) != 0) {
+    throw py::error_already_set();
+  }
+  string str(static_cast<const char *>(view.buf), view.len);
+  PyBuffer_Release(&view);
+  return str;
+}
+
+py::tuple Mapper::args_to_tuple(const Array &args) {
+  py::tuple tuple(args.size());
+  for (size_t i = 0; i < args.size(); ++i) {
+    PyTuple_SET_ITEM(tuple.ptr(), i, value_to_python(args[i]).release().ptr());
+  }
+  return tuple;
+}
+
+py::tuple Mapper::args_to_tuple(const Array &args, const py::handle &self) {
+  py::tuple tuple(args.size() + 1);
+  PyTuple_SET_ITEM(tuple.ptr(), 0, self.inc_ref().ptr());
+  for (size_t i = 0; i < args.size(); ++i) {
+    PyTuple_SET_ITEM(tuple.ptr(), i + 1,
+                     value_to_python(args[i]).release().ptr());
   }
+  return tuple;
 }
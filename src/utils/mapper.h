@@ -18,11 +18,51 @@
 #include <pybind11/pybind11.h>
 #include <complate/core/value.h>
 
+#include <memory>
+#include <string>
+
 class Mapper {
 public:
   Mapper() = delete;
 
+  /** Name of the prototype, which exposes a dict lazily to the views. */
+  static const char *const LAZY_DICT;
+  /** Key marking parameters, which contain lazily exposed dicts. */
+  static const char *const LAZY_MARKER;
+  /** Name of the prototype, which exposes objects of frozen bindings. */
+  static const char *const FROZEN;
+
+  /** Object of frozen bindings, its proxy keeps the whole tree alive. */
+  struct FrozenNode {
+    std::shared_ptr<const complate::Value> root;
+    const complate::Object *object;
+  };
+
+  /**
+   * Marks a call from a view into Python on this thread.
+   *
+   * JavaScript functions, which are passed to Python meanwhile, belong to the
+   * runtime of that view. They are only callable until the outermost call
+   * has returned and only on this thread, they raise a RuntimeError
+   * otherwise.
+   */
+  class Call {
+  public:
+    Call();
+    ~Call();
+    Call(const Call &) = delete;
+    Call &operator=(const Call &) = delete;
+  };
+
+  static complate::Value python_to_value(const pybind11::handle &obj,
+                                         bool lazy = false);
+  static complate::Object python_to_object(const pybind11::dict &dict,
+                                           bool lazy = false);
   static pybind11::object value_to_python(const complate::Value &value);
+  /** Copy a JSON document from bytes-like objects without decoding it. */
+  static std::string buffer_to_string(const pybind11::buffer &buffer);
   static pybind11::tuple args_to_tuple(const complate::Array &args);
+  static pybind11::tuple args_to_tuple(const complate::Array &args,
+                                       const pybind11::handle &self);
 };
 
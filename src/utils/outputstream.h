@@ -0,0 +1,58 @@
+/**
+ * Copyright 2021 Torsten Mehnert
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+#pragma once
+
+#include <complate/core/stream.h>
+#include <pybind11/pybind11.h>
+
+#include <string>
+#include <utility>
+
+/**
+ * Stream collecting the rendered output, which is handed over without copies.
+ *
+ * Unlike the StringStream of complate, the output is available by reference
+ * and can be moved out, so it's copied only once into a Python object.
+ */
+class OutputStream : public complate::Stream {
+public:
+  void write(const char *str, int len) override { m_output.append(str, len); }
+
+  void writeln(const char *str, int len) override {
+    m_output.append(str, len);
+    m_output.push_back('\n');
+  }
+
+  void flush() override {}
+
+  [[nodiscard]] const std::string &str() const { return m_output; }
+
+  /** The output as bytes, copied once. */
+  [[nodiscard]] pybind11::bytes bytes() const {
+    auto obj = PyBytes_FromStringAndSize(
+        m_output.data(), static_cast<Py_ssize_t>(m_output.size()));
+    if (!obj) {
+      throw pybind11::error_already_set();
+    }
+    return pybind11::reinterpret_steal<pybind11::bytes>(obj);
+  }
+
+  /** Move the output out of the stream, which is empty afterwards. */
+  [[nodiscard]] std::string take() { return std::exchange(m_output, {}); }
+
+private:
+  std::string m_output;
+};
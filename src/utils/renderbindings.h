@@ -0,0 +1,199 @@
+/**
+ * Copyright 2021 Torsten Mehnert
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+#pragma once
+
+#include <complate/core/renderer.h>
+#include <pybind11/pybind11.h>
+
+#include <string>
+
+#include "deadline.h"
+#include "jsonwriter.h"
+#include "mapper.h"
+#include "outputstream.h"
+
+static const char RENDERER_DOC_TOBYTES[] = R"DELIM(
+  Render a view to bytes using a JSON string as parameters.
+
+  The output is returned as UTF-8 encoded bytes, so it can be passed to a
+  response without being decoded and encoded again.
+)DELIM";
+
+static void checkDictOptions(bool lazy, bool asJson) {
+  if (asJson && lazy) {
+    throw pybind11::value_error("Pass either lazy or as_json, not both");
+  }
+}
+
+static void renderDict(complate::Renderer &renderer, const std::string &view,
+                       const pybind11::dict &parameters,
+                       complate::Stream &stream, bool lazy, bool asJson) {
+  checkDictOptions(lazy, asJson);
+  if (asJson) {
+    JsonBuffer json(parameters);
+    renderer.render(view, json.str(), stream);
+  } else {
+    renderer.render(view, Mapper::python_to_object(parameters, lazy), stream);
+  }
+}
+
+/** Render with a deadline timeoutMs from now, which is checked on writes. */
+template <typename Render>
+static void renderWithin(double timeoutMs, complate::Stream &stream,
+                         const Render &render) {
+  auto at = Deadline::after(timeoutMs);
+  Deadline::run(at, [&] {
+    if (at) {
+      DeadlineStream checked(stream);
+      render(checked);
+    } else {
+      render(stream);
+    }
+  });
+}
+
+/** Renders dict parameters, renderers measuring the conversion replace it. */
+using RenderDict = void (*)(complate::Renderer &, const std::string &,
+                            const pybind11::dict &, complate::Stream &, bool,
+                            bool);
+
+/**
+ * Define render(), render_tostring() and render_tobytes() with all their
+ * overloads, which classes overriding one of them have to define again.
+ */
+template <typename Class, typename... Options>
+static void defineRender(pybind11::class_<Class, Options...> &cls,
+                         RenderDict renderParameters = &renderDict) {
+  namespace py = pybind11;
+  using namespace std;
+  using namespace complate;
+
+  cls.def(
+      "render",
+      [](Renderer &renderer, const string &view, const string &parameters,
+         Stream &stream, double timeoutMs) {
+        renderWithin(timeoutMs, stream, [&](Stream &out) {
+          renderer.render(view, parameters, out);
+        });
+      },
+      "Render a view to a Stream using a JSON string as parameters.",
+      py::arg("view"), py::arg("parameters"), py::arg("stream"),
+      py::arg("timeout_ms") = 0.0);
+  cls.def(
+      "render",
+      [renderParameters](Renderer &renderer, const string &view,
+                         const py::dict &parameters, Stream &stream,
+                         bool lazy, bool asJson, double timeoutMs) {
+        renderWithin(timeoutMs, stream, [&](Stream &out) {
+          renderParameters(renderer, view, parameters, out, lazy, asJson);
+        });
+      },
+      "Render a view to a Stream using a dict as parameters.",
+      py::arg("view"), py::arg("parameters"), py::arg("stream"),
+      py::arg("lazy") = false, py::arg("as_json") = false,
+      py::arg("timeout_ms") = 0.0);
+  cls.def(
+      "render",
+      [](Renderer &renderer, const string &view,
+         const py::buffer &parameters, Stream &stream, double timeoutMs) {
+        auto json = Mapper::buffer_to_string(parameters);
+        renderWithin(timeoutMs, stream, [&](Stream &out) {
+          renderer.render(view, json, out);
+        });
+      },
+      "Render a view to a Stream using UTF-8 encoded JSON as parameters.",
+      py::arg("view"), py::arg("parameters"), py::arg("stream"),
+      py::arg("timeout_ms") = 0.0);
+  cls.def(
+      "render_tostring",
+      [](Renderer &renderer, const string &view, const string &parameters,
+         double timeoutMs) {
+        OutputStream stream;
+        renderWithin(timeoutMs, stream, [&](Stream &out) {
+          renderer.render(view, parameters, out);
+        });
+        return py::str(stream.str());
+      },
+      "Render a view to a Stream using a JSON string as parameters.",
+      py::arg("view"), py::arg("parameters"), py::arg("timeout_ms") = 0.0);
+  cls.def(
+      "render_tostring",
+      [renderParameters](Renderer &renderer, const string &view,
+                         const py::dict &parameters, bool lazy, bool asJson,
+                         double timeoutMs) {
+        OutputStream stream;
+        renderWithin(timeoutMs, stream, [&](Stream &out) {
+          renderParameters(renderer, view, parameters, out, lazy, asJson);
+        });
+        return py::str(stream.str());
+      },
+      "Render a view to a String using a dict as parameters.",
+      py::arg("view"), py::arg("parameters"), py::arg("lazy") = false,
+      py::arg("as_json") = false, py::arg("timeout_ms") = 0.0);
+  cls.def(
+      "render_tostring",
+      [](Renderer &renderer, const string &view,
+         const py::buffer &parameters, double timeoutMs) {
+        auto json = Mapper::buffer_to_string(parameters);
+        OutputStream stream;
+        renderWithin(timeoutMs, stream, [&](Stream &out) {
+          renderer.render(view, json, out);
+        });
+        return py::str(stream.str());
+      },
+      "Render a view to a String using UTF-8 encoded JSON as parameters.",
+      py::arg("view"), py::arg("parameters"), py::arg("timeout_ms") = 0.0);
+  cls.def(
+      "render_tobytes",
+      [](Renderer &renderer, const string &view, const string &parameters,
+         double timeoutMs) {
+        OutputStream stream;
+        renderWithin(timeoutMs, stream, [&](Stream &out) {
+          renderer.render(view, parameters, out);
+        });
+        return stream.bytes();
+      },
+      RENDERER_DOC_TOBYTES, py::arg("view"), py::arg("parameters"),
+      py::arg("timeout_ms") = 0.0);
+  cls.def(
+      "render_tobytes",
+      [renderParameters](Renderer &renderer, const string &view,
+                         const py::dict &parameters, bool lazy, bool asJson,
+                         double timeoutMs) {
+        OutputStream stream;
+        renderWithin(timeoutMs, stream, [&](Stream &out) {
+          renderParameters(renderer, view, parameters, out, lazy, asJson);
+        });
+        return stream.bytes();
+      },
+      "Render a view to UTF-8 encoded bytes using a dict as parameters.",
+      py::arg("view"), py::arg("parameters"), py::arg("lazy") = false,
+      py::arg("as_json") = false, py::arg("timeout_ms") = 0.0);
+  cls.def(
+      "render_tobytes",
+      [](Renderer &renderer, const string &view,
+         const py::buffer &parameters, double timeoutMs) {
+        auto json = Mapper::buffer_to_string(parameters);
+        OutputStream stream;
+        renderWithin(timeoutMs, stream, [&](Stream &out) {
+          renderer.render(view, json, out);
+        });
+        return stream.bytes();
+      },
+      "Render a view to UTF-8 encoded bytes using UTF-8 encoded JSON as "
+      "parameters.",
+      py::arg("view"), py::arg("parameters"), py::arg("timeout_ms") = 0.0);
+}
@@ -0,0 +1,53 @@
+/**
+ * Copyright 2021 Torsten Mehnert
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+#include "renderstats.h"
+
+#include <algorithm>
+
+#include "threadstate.h"
+
+RenderStats *RenderStats::current() { return ThreadState::current().stats; }
+
+void RenderStats::add(const RenderStats &other) {
+  conversion += other.conversion;
+  javascript += other.javascript;
+  stream += other.stream;
+  callbacks += other.callbacks;
+  bytes += other.bytes;
+  writes += other.writes;
+  calls += other.calls;
+  heapBytes = std::max(heapBytes, other.heapBytes);
+  heapObjects = std::max(heapObjects, other.heapObjects);
+}
+
+RenderStats::Scope::Scope(RenderStats *stats) : m_previous(current()) {
+  ThreadState::current().stats = stats;
+}
+
+RenderStats::Scope::~Scope() { ThreadState::current().stats = m_previous; }
+
+RenderStats::Callback::Callback() : m_stats(current()) {
+  if (m_stats) {
+    m_start = Clock::now();
+  }
+}
+
+RenderStats::Callback::~Callback() {
+  if (m_stats) {
+    m_stats->callbacks += Clock::now() - m_start;
+    ++m_stats->calls;
+  }
+}
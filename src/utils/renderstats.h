@@ -0,0 +1,73 @@
+/**
+ * Copyright 2021 Torsten Mehnert
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+
+/**
+ * Where the time of a single render went and how much output it wrote.
+ *
+ * Instrumented renders make their stats current on the rendering thread, so
+ * calls into Python can add their time without knowing about the renderer.
+ * They are part of the ThreadState, so calls made by functions of any
+ * extension module are counted.
+ */
+struct RenderStats {
+  using Clock = std::chrono::steady_clock;
+
+  Clock::duration conversion{0};
+  Clock::duration javascript{0};
+  Clock::duration stream{0};
+  Clock::duration callbacks{0};
+  std::size_t bytes = 0;
+  std::size_t writes = 0;
+  std::size_t calls = 0;
+  /** Heap of the QuickJS runtime after the render, add() keeps the larger. */
+  std::size_t heapBytes = 0;
+  std::size_t heapObjects = 0;
+
+  /** Stats of the instrumented render running on this thread, or nullptr. */
+  static RenderStats *current();
+
+  /** Add the stats of a part of this render, measured elsewhere. */
+  void add(const RenderStats &other);
+
+  /** Makes stats current on this thread for the lifetime of the scope. */
+  class Scope {
+  public:
+    explicit Scope(RenderStats *stats);
+    ~Scope();
+    Scope(const Scope &) = delete;
+    Scope &operator=(const Scope &) = delete;
+
+  private:
+    RenderStats *m_previous;
+  };
+
+  /** Adds its lifetime to the callback time of the current render, if any. */
+  class Callback {
+  public:
+    Callback();
+    ~Callback();
+    Callback(const Callback &) = delete;
+    Callback &operator=(const Callback &) = delete;
+
+  private:
+    RenderStats *m_stats;
+    Clock::time_point m_start;
+  };
+};
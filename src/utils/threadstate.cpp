@@ -0,0 +1,39 @@
+/**
+ * Copyright 2021 Torsten Mehnert
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+#include "threadstate.h"
+
+namespace py = pybind11;
+
+namespace {
+ThreadState &local() {
+  thread_local ThreadState state;
+  return state;
+}
+
+ThreadState &(*resolve)() = &local;
+}  // namespace
+
+ThreadState &ThreadState::current() { return resolve(); }
+
+py::capsule ThreadState::capsule() {
+  return py::capsule(reinterpret_cast<void *>(resolve),
+                     "complatecpp.threadstate");
+}
+
+void ThreadState::link(const py::capsule &capsule) {
+  void *ptr = capsule;
+  resolve = reinterpret_cast<ThreadState &(*)()>(ptr);
+}
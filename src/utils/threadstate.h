@@ -0,0 +1,61 @@
+/**
+ * Copyright 2021 Torsten Mehnert
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+#pragma once
+
+#include <pybind11/pybind11.h>
+
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <thread>
+
+struct RenderStats;
+
+/**
+ * State of the render running on this thread.
+ *
+ * Every extension module compiles its own copy of the utils, so the other
+ * modules link() to the state of the core module. Otherwise a view rendered
+ * by one module wouldn't see the deadline or stats made current by another.
+ */
+struct ThreadState {
+  struct Deadline {
+    std::optional<std::chrono::steady_clock::time_point> at;
+    /** Set when a check found the deadline passed. */
+    bool expired = false;
+  };
+
+  /** Valid while a view calls into Python on the thread owning its runtime. */
+  struct Liveness {
+    std::thread::id owner = std::this_thread::get_id();
+    bool alive = true;
+  };
+
+  Deadline deadline;
+  /** Stats of the instrumented render running on this thread, or nullptr. */
+  RenderStats *stats = nullptr;
+  /** Token of the outermost call from a view into Python, if any. */
+  std::shared_ptr<Liveness> liveness;
+  std::size_t calls = 0;
+
+  [[nodiscard]] static ThreadState &current();
+
+  /** Expose the state of this module to other extension modules. */
+  [[nodiscard]] static pybind11::capsule capsule();
+  /** Use the state of the module, which created the capsule. */
+  static void link(const pybind11::capsule &capsule);
+};
@@ -35,6 +35,11 @@ def views():
         return views.read()
 
 
+@pytest.fixture
+def views_path():
+    return resource_path("views.js")
+
+
 @pytest.fixture
 def views_creator(views):
     return lambda: views
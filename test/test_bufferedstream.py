@@ -0,0 +1,108 @@
+# Copyright 2021 Torsten Mehnert
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#      http://www.apache.org/licenses/LICENSE-2.0
+#
+#  Unless required by applicable law or agreed to in writing, software
+#  distributed under the License is distributed on an "AS IS" BASIS,
+#  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+#  See the License for the specific language governing permissions and
+#  limitations under the License.
+import gc
+import io
+from complatecpp import BufferedStream, QuickJsRenderer
+
+from fixtures.teststream import TestStream
+
+
+class RecordingTarget:
+    def __init__(self):
+        self.chunks = []
+        self.flushed = 0
+
+    def write(self, chunk):
+        self.chunks.append(chunk)
+
+    def flush(self):
+        self.flushed += 1
+
+
+def test_write_is_buffered():
+    target = RecordingTarget()
+    stream = BufferedStream(target)
+    stream.write(string="7 chars", length=7)
+    stream.writeln(string="7 chars", length=7)
+    assert target.chunks == []
+    assert stream.buffered == 15
+
+
+def test_flush_forwards_single_chunk():
+    target = RecordingTarget()
+    stream = BufferedStream(target)
+    stream.write(string="7 chars", length=7)
+    stream.writeln(string="7 chars", length=7)
+    stream.flush()
+    assert target.chunks == [b"7 chars7 chars\n"]
+    assert target.flushed == 1
+    assert stream.buffered == 0
+
+
+def test_forwards_on_threshold():
+    target = RecordingTarget()
+    stream = BufferedStream(target, threshold=8)
+    stream.write(string="4 ch", length=4)
+    stream.write(string="4 ch", length=4)
+    stream.write(string="4 ch", length=4)
+    assert target.chunks == [b"4 ch4 ch"]
+
+
+def test_forwards_to_file_like():
+    target = io.BytesIO()
+    stream = BufferedStream(target)
+    stream.writeln(string="7 chars", length=7)
+    stream.flush()
+    assert target.getvalue() == b"7 chars\n"
+
+
+def test_forwards_to_stream():
+    target = TestStream()
+    stream = BufferedStream(target)
+    stream.write(string="Hello", length=5)
+    stream.writeln(string=" World", length=6)
+    stream.flush()
+    assert target.str() == "Hello World\n"
+
+
+def test_forwards_complete_characters_to_stream():
+    target = TestStream()
+    stream = BufferedStream(target, threshold=4)
+    stream.write(string="abcä", length=4)
+    assert target.str() == "abc"
+    assert stream.buffered == 1
+
+
+def test_forwards_on_destruction():
+    target = RecordingTarget()
+    stream = BufferedStream(target)
+    stream.writeln(string="7 chars", length=7)
+    del stream
+    gc.collect()
+    assert target.chunks == [b"7 chars\n"]
+    assert target.flushed == 1
+
+
+def test_use_with_renderer(views_mock):
+    target = RecordingTarget()
+    stream = BufferedStream(target)
+    renderer = QuickJsRenderer(views_mock)
+    renderer.render("Mock", {"name": "John Doe"}, stream)
+    stream.flush()
+    assert b"".join(target.chunks) == b"""
+View: Mock
+Parameters: {"name":"John Doe"}
+"""
+    assert target.flushed >= 1
+    assert stream.buffered == 0
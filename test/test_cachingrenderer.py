@@ -0,0 +1,130 @@
+# Copyright 2021 Torsten Mehnert
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#      http://www.apache.org/licenses/LICENSE-2.0
+#
+#  Unless required by applicable law or agreed to in writing, software
+#  distributed under the License is distributed on an "AS IS" BASIS,
+#  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+#  See the License for the specific language governing permissions and
+#  limitations under the License.
+import time
+import pytest
+from complatecpp import CachingRenderer, QuickJsRendererBuilder, StringStream
+
+
+@pytest.fixture
+def calls():
+    return []
+
+
+@pytest.fixture
+def counting_renderer(calls):
+    source = """
+    function render(view, parameters, stream) {
+        count(view);
+        stream.write(view + ":" + JSON.stringify(parameters));
+    }
+    """
+    return QuickJsRendererBuilder() \
+        .source(source) \
+        .bindings({"count": lambda view: calls.append(view)}) \
+        .unique()
+
+
+def test_render_dict_is_cached(counting_renderer, calls):
+    renderer = CachingRenderer(counting_renderer)
+    assert renderer.render_tostring("View", {"a": [1, 2]}) == 'View:{"a":[1,2]}'
+    assert renderer.render_tostring("View", {"a": [1, 2]}) == 'View:{"a":[1,2]}'
+    assert calls == ["View"]
+    stats = renderer.stats()
+    assert stats["hits"] == 1 and stats["misses"] == 1 and stats["bypasses"] == 0
+    assert stats["entries"] == 1
+    # The output and the parameters it was rendered with
+    assert stats["bytes"] > 16
+
+
+def test_render_json_is_cached(counting_renderer, calls):
+    renderer = CachingRenderer(counting_renderer)
+    stream = StringStream()
+    renderer.render("View", '{"a":1}', stream)
+    renderer.render("View", '{"a":1}', stream)
+    assert stream.str() == 'View:{"a":1}View:{"a":1}'
+    assert calls == ["View"]
+
+
+def test_keyed_by_view_and_parameters(counting_renderer, calls):
+    renderer = CachingRenderer(counting_renderer)
+    renderer.render_tostring("View", {"a": 1})
+    renderer.render_tostring("Other", {"a": 1})
+    renderer.render_tostring("View", {"a": 2})
+    renderer.render_tostring("View", {"a": "1"})
+    assert calls == ["View", "Other", "View", "View"]
+    assert renderer.stats()["entries"] == 4
+
+
+def test_keyed_by_whole_parameters(counting_renderer, calls):
+    renderer = CachingRenderer(counting_renderer)
+    first = {"user": "a" * 1000 + "1"}
+    second = {"user": "a" * 1000 + "2"}
+    assert renderer.render_tostring("View", first).endswith('1"}')
+    assert renderer.render_tostring("View", second).endswith('2"}')
+    assert calls == ["View", "View"]
+
+
+def test_bypasses_objects(counting_renderer, calls):
+    renderer = CachingRenderer(counting_renderer)
+    renderer.render_tostring("View", {"f": lambda: 1})
+    renderer.render_tostring("View", {"f": lambda: 1})
+    assert calls == ["View", "View"]
+    assert renderer.stats()["bypasses"] == 2
+
+
+def test_evicts_least_recently_used(counting_renderer, calls):
+    renderer = CachingRenderer(counting_renderer, max_entries=2)
+    renderer.render_tostring("A", {})
+    renderer.render_tostring("B", {})
+    renderer.render_tostring("A", {})
+    renderer.render_tostring("C", {})
+    renderer.render_tostring("A", {})
+    renderer.render_tostring("B", {})
+    assert calls == ["A", "B", "C", "B"]
+
+
+def test_evicts_by_bytes(counting_renderer, calls):
+    renderer = CachingRenderer(counting_renderer, max_bytes=40)
+    renderer.render_tostring("A", {})
+    renderer.render_tostring("B", {})
+    renderer.render_tostring("B", {})
+    renderer.render_tostring("A", {})
+    assert calls == ["A", "B", "A"]
+    assert renderer.stats()["entries"] == 1
+    assert renderer.stats()["bytes"] <= 40
+
+
+def test_expires_after_ttl(counting_renderer, calls):
+    renderer = CachingRenderer(counting_renderer, ttl=0.05)
+    renderer.render_tostring("A", {})
+    time.sleep(0.1)
+    renderer.render_tostring("A", {})
+    assert calls == ["A", "A"]
+
+
+def test_clear(counting_renderer, calls):
+    renderer = CachingRenderer(counting_renderer)
+    renderer.render_tostring("A", {})
+    renderer.clear()
+    renderer.render_tostring("A", {})
+    assert calls == ["A", "A"]
+    assert renderer.stats()["entries"] == 1
+
+
+def test_errors_are_not_cached(views):
+    renderer = CachingRenderer(QuickJsRendererBuilder().source(views).unique())
+    for _ in range(2):
+        with pytest.raises(RuntimeError, match=".*MissingView.*"):
+            renderer.render_tostring("MissingView", {})
+    assert renderer.stats()["entries"] == 0
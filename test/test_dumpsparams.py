@@ -0,0 +1,119 @@
+# Copyright 2021 Torsten Mehnert
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#      http://www.apache.org/licenses/LICENSE-2.0
+#
+#  Unless required by applicable law or agreed to in writing, software
+#  distributed under the License is distributed on an "AS IS" BASIS,
+#  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+#  See the License for the specific language governing permissions and
+#  limitations under the License.
+import gc
+import json
+import math
+import pytest
+import weakref
+from dataclasses import dataclass
+from enum import Enum, IntEnum
+from complatecpp import dumps_params
+from fixtures.encoder import Encoder
+
+
+@dataclass
+class Point:
+    x: int
+    y: float
+    label: str = "origin"
+
+
+class Slotted:
+    __slots__ = ["name", "_hidden"]
+
+    def __init__(self, name):
+        self.name = name
+        self._hidden = True
+
+
+def test_dumps_scalars_and_containers():
+    obj = {"str": "Grüße", "int": 2 ** 70, "float": 0.1, "bool": True, "none": None,
+           "list": [1, "two", [3]], "tuple": (1, 2), "dict": {"nested": {"deeper": False}}, 1: "key"}
+    assert json.loads(dumps_params(obj)) == json.loads(json.dumps(obj))
+
+
+def test_dumps_escapes_strings():
+    text = 'quote " backslash \\ newline \n tab \t control \x01 unicode  '
+    assert json.loads(dumps_params({"text": text})) == {"text": text}
+
+
+def test_dumps_escapes_lone_surrogates():
+    text = "lone \ud800 pair \ud83d\ude00 end"
+    assert dumps_params({"text": text}) == json.dumps({"text": text}, separators=(",", ":")).encode()
+
+
+def test_dumps_releases_classes():
+    cls = type("Temporary", (), {"value": property(lambda self: 1)})
+    assert dumps_params(cls()) == b'{"value":1}'
+    ref = weakref.ref(cls)
+    del cls
+    gc.collect()
+    assert ref() is None
+
+
+def test_dumps_returns_bytes():
+    assert dumps_params({"a": [1, 2.5]}) == b'{"a":[1,2.5]}'
+
+
+def test_dumps_objects(todolist_parameters):
+    expected = json.loads(json.dumps(todolist_parameters, cls=Encoder))
+    assert json.loads(dumps_params(todolist_parameters)) == expected
+
+
+def test_dumps_dataclass_and_slots():
+    assert json.loads(dumps_params([Point(1, 2.0), Slotted("slots")])) == [
+        {"x": 1, "y": 2.0, "label": "origin"},
+        {"name": "slots"}
+    ]
+
+
+def test_dumps_throws_on_nan():
+    with pytest.raises(ValueError):
+        dumps_params({"nan": math.nan})
+
+
+def test_dumps_throws_on_unsupported():
+    with pytest.raises(TypeError):
+        dumps_params({"set": {1, 2}})
+    with pytest.raises(TypeError):
+        dumps_params({"function": lambda: 1})
+
+
+class Color(Enum):
+    RED = 1
+
+
+class Level(IntEnum):
+    HIGH = 2
+
+
+def test_dumps_keys_like_json():
+    obj = {True: 1, False: 2, None: 3, 4: 4, 2.5: 5, math.inf: 6, -math.inf: 7, Level.HIGH: 8}
+    assert dumps_params(obj) == json.dumps(obj, separators=(",", ":")).encode()
+
+
+def test_dumps_throws_on_unsupported_keys():
+    with pytest.raises(TypeError, match="keys must be str"):
+        dumps_params({(1, 2): "tuple"})
+
+
+def test_dumps_throws_on_enums():
+    with pytest.raises(TypeError, match="Color"):
+        dumps_params({"color": Color.RED})
+    assert dumps_params({"level": Level.HIGH}) == b'{"level":2}'
+
+
+def test_render_dumped_params(quickjs_renderer, todolist_parameters, todolist_html):
+    html = quickjs_renderer.render_tostring("TodoList", dumps_params(todolist_parameters))
+    assert html == todolist_html
@@ -76,11 +76,10 @@ def test_with_default_argument():
     assert func.apply([1]) == 2
 
 
-def test_throws_on_more_than_8_arguments():
-    value = Value(lambda: "Too much arguments")
+def test_with_more_than_8_arguments():
+    value = Value(lambda *args: sum(args))
     func = value.get_function()
-    with pytest.raises(ValueError, match=".*More then 8 arguments are not supported.*"):
-        func.apply([1, 2, 3, 4, 5, 6, 7, 8, 9])
+    assert func.apply(list(range(20))) == 190
 
 
 def test_throws_on_missing_arguments():
@@ -95,3 +94,25 @@ def test_throws_on_too_much_arguments():
     func = value.get_function()
     with pytest.raises(TypeError, match=".*takes 1 positional argument but 2 were given.*"):
         func.apply([1, 2])
+
+
+def test_with_container_arguments():
+    value = Value(lambda a1, a2: (a1, a2))
+    func = value.get_function()
+    assert func.apply([[1, "two", None], {"key": [True, 2.5]}]) == [[1, "two", None], {"key": [True, 2.5]}]
+
+
+def test_with_function_argument():
+    value = Value(lambda callback: callback(20) + 2)
+    func = value.get_function()
+    assert func.apply([lambda x: x * 2]) == 42
+
+
+def test_with_object_argument():
+    class Person:
+        pass
+
+    person = Person()
+    value = Value(lambda p: p)
+    func = value.get_function()
+    assert func.apply([person]) is person
@@ -0,0 +1,132 @@
+# Copyright 2021 Torsten Mehnert
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#      http://www.apache.org/licenses/LICENSE-2.0
+#
+#  Unless required by applicable law or agreed to in writing, software
+#  distributed under the License is distributed on an "AS IS" BASIS,
+#  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+#  See the License for the specific language governing permissions and
+#  limitations under the License.
+import json
+import pytest
+from complatecpp import InstrumentedRenderer, QuickJsRendererBuilder, StringStream, Value, runtime_hook
+from fixtures.encoder import Encoder
+
+
+def test_render_dict_reports_stats(quickjs_renderer, todolist_parameters, todolist_html):
+    reported = []
+    renderer = InstrumentedRenderer(quickjs_renderer, reported.append)
+    assert renderer.render_tostring("TodoList", todolist_parameters) == todolist_html
+    assert len(reported) == 1
+    stats = reported[0]
+    assert stats["view"] == "TodoList"
+    assert stats["bytes"] == len(todolist_html.encode("utf-8"))
+    assert stats["writes"] > 0
+    assert stats["calls"] > 0
+    for key in ["conversion", "javascript", "stream", "callbacks"]:
+        assert 0 <= stats[key] <= stats["total"]
+
+
+def test_render_json_reports_stats(quickjs_renderer, todolist_parameters, todolist_html):
+    reported = []
+    renderer = InstrumentedRenderer(quickjs_renderer, reported.append)
+    stream = StringStream()
+    renderer.render("TodoList", json.dumps(todolist_parameters, cls=Encoder), stream)
+    assert stream.str() == todolist_html
+    assert reported[0]["conversion"] == 0
+
+
+def test_measures_callbacks():
+    source = """
+    function render(view, parameters, stream) {
+        stream.write(String(slow() + parameters.add(1)))
+    }
+    """
+    reported = []
+    renderer = InstrumentedRenderer(
+        QuickJsRendererBuilder().source(source).bindings({"slow": lambda: sum(range(100000))}).unique(),
+        reported.append)
+    assert renderer.render_tostring("View", {"add": lambda x: x + 1}) == "4999950002"
+    assert reported[0]["calls"] == 2
+    assert reported[0]["callbacks"] > 0
+
+
+def test_stats_per_view(views_mock):
+    renderer = InstrumentedRenderer(QuickJsRendererBuilder().source(views_mock).unique())
+    renderer.render_tostring("A", {})
+    renderer.render_tostring("A", "{}")
+    renderer.render_tobytes("B", {})
+    stats = renderer.stats()
+    assert sorted(stats.keys()) == ["A", "B"]
+    assert stats["A"]["count"] == 2
+    assert stats["A"]["buckets"][-1] == (float("inf"), 2)
+    assert [count for _, count in stats["A"]["buckets"]] == sorted(count for _, count in stats["A"]["buckets"])
+    assert stats["B"]["bytes"] == len(renderer.render_tobytes("B", {}))
+    renderer.reset()
+    assert renderer.stats() == {}
+
+
+def test_measures_pool(views, bindings, prototypes, todolist_parameters):
+    reported = []
+    pool = QuickJsRendererBuilder().source(views).bindings(bindings).prototypes(prototypes).pool(2)
+    renderer = InstrumentedRenderer(pool, reported.append)
+    renderer.render_tostring("TodoList", todolist_parameters)
+    assert reported[0]["calls"] > 0
+
+
+def test_counts_writes_of_pool_with_timeout(quickjs_renderer, views, bindings, prototypes, todolist_parameters):
+    reported = []
+    InstrumentedRenderer(quickjs_renderer, reported.append).render_tostring("TodoList", todolist_parameters)
+    pool = QuickJsRendererBuilder().source(views).bindings(bindings).prototypes(prototypes).timeout(60000).pool(2)
+    InstrumentedRenderer(pool, reported.append).render_tostring("TodoList", todolist_parameters)
+    assert reported[1]["writes"] == reported[0]["writes"] > 1
+    assert reported[1]["bytes"] == reported[0]["bytes"]
+
+
+@pytest.mark.skipif(not runtime_hook, reason="requires the runtime hook")
+def test_reports_heap(views, bindings, prototypes, todolist_parameters):
+    reported = []
+    builder = QuickJsRendererBuilder().source(views).bindings(bindings).prototypes(prototypes)
+    renderer = InstrumentedRenderer(builder.unique(), reported.append)
+    renderer.render_tostring("TodoList", todolist_parameters)
+    InstrumentedRenderer(builder.pool(1), reported.append).render_tostring("TodoList", todolist_parameters)
+    for stats in reported:
+        assert stats["heap_bytes"] > 0
+        assert stats["heap_objects"] > 0
+    assert renderer.stats()["TodoList"]["heap_bytes"] == reported[0]["heap_bytes"]
+
+
+def test_errors_propagate(views_mock):
+    renderer = InstrumentedRenderer(QuickJsRendererBuilder().source(views_mock).unique())
+    with pytest.raises(RuntimeError):
+        renderer.render_tostring("View", "")
+
+
+def test_supports_render_options(quickjs_renderer, todolist_parameters, todolist_html):
+    reported = []
+    renderer = InstrumentedRenderer(quickjs_renderer, reported.append)
+    assert renderer.render_tostring("TodoList", todolist_parameters, as_json=True) == todolist_html
+    assert renderer.render_tostring("TodoList", todolist_parameters, lazy=True) == todolist_html
+    assert renderer.render_tostring("TodoList", todolist_parameters, timeout_ms=60000) == todolist_html
+    body = json.dumps(todolist_parameters, cls=Encoder).encode("utf-8")
+    assert renderer.render_tobytes("TodoList", memoryview(body), timeout_ms=60000) == todolist_html.encode("utf-8")
+    assert len(reported) == 4
+    assert reported[0]["conversion"] > 0
+    with pytest.raises(ValueError, match="either lazy or as_json"):
+        renderer.render_tostring("TodoList", todolist_parameters, lazy=True, as_json=True)
+
+
+def test_counts_calls_of_functions_from_core():
+    source = """
+    function render(view, parameters, stream) {
+        stream.write(String(parameters.add(1)))
+    }
+    """
+    reported = []
+    renderer = InstrumentedRenderer(QuickJsRendererBuilder().source(source).unique(), reported.append)
+    assert renderer.render_tostring("View", {"add": Value(lambda x: x + 1)}) == "2"
+    assert reported[0]["calls"] == 1
@@ -13,7 +13,7 @@
 #  limitations under the License.
 import pytest
 import json
-from complatecpp import QuickJsRenderer, StringStream
+from complatecpp import QuickJsRenderer, QuickJsRendererBuilder, StringStream
 from fixtures.encoder import Encoder
 
 
@@ -79,3 +79,206 @@ def test_render_json_tostring(quickjs_renderer, todolist_parameters, todolist_ht
         parameters=json.dumps(todolist_parameters, cls=Encoder)
     )
     assert html == todolist_html
+
+
+def test_render_dict_tobytes(quickjs_renderer, todolist_parameters, todolist_html):
+    html = quickjs_renderer.render_tobytes(
+        view="TodoList",
+        parameters=todolist_parameters
+    )
+    assert html == todolist_html.encode("utf-8")
+
+
+def test_render_json_tobytes(quickjs_renderer, todolist_parameters, todolist_html):
+    html = quickjs_renderer.render_tobytes(
+        view="TodoList",
+        parameters=json.dumps(todolist_parameters, cls=Encoder)
+    )
+    assert html == todolist_html.encode("utf-8")
+
+
+def test_render_json_bytes_like(quickjs_renderer, todolist_parameters, todolist_html):
+    parameters = json.dumps(todolist_parameters, cls=Encoder).encode("utf-8")
+    assert quickjs_renderer.render_tostring("TodoList", parameters) == todolist_html
+    assert quickjs_renderer.render_tostring("TodoList", bytearray(parameters)) == todolist_html
+    assert quickjs_renderer.render_tobytes("TodoList", memoryview(parameters)) == todolist_html.encode("utf-8")
+    stream = StringStream()
+    quickjs_renderer.render("TodoList", memoryview(parameters), stream)
+    assert stream.str() == todolist_html
+
+
+def test_render_batch(quickjs_renderer, todolist_parameters, todolist_html):
+    json_parameters = json.dumps(todolist_parameters, cls=Encoder)
+    html = quickjs_renderer.render_batch([
+        ("TodoList", todolist_parameters),
+        ("TodoList", json_parameters)
+    ])
+    assert html == [todolist_html, todolist_html]
+
+
+def test_render_batch_as_bytes(quickjs_renderer, todolist_parameters, todolist_html):
+    html = quickjs_renderer.render_batch([("TodoList", todolist_parameters)], as_bytes=True)
+    assert html == [todolist_html.encode("utf-8")]
+
+
+def test_render_batch_throws_view_undefined(quickjs_renderer, todolist_parameters):
+    with pytest.raises(RuntimeError, match=".*MissingView.*"):
+        quickjs_renderer.render_batch([("TodoList", todolist_parameters), ("MissingView", {})])
+
+
+def test_render_dict_converts_values(views_mock):
+    renderer = QuickJsRenderer(views_mock)
+    html = renderer.render_tostring("Mock", {
+        "str": "Grüße",
+        "int": 2 ** 40,
+        "float": 0.5,
+        "bool": True,
+        "none": None,
+        "list": [1, "two", [3]],
+        "tuple": (1, 2),
+        "dict": {"nested": {"deeper": False}},
+        1: "non string key"
+    })
+    assert html == '''
+View: Mock
+Parameters: {"1":"non string key","bool":true,"dict":{"nested":{"deeper":false}},"float":0.5,"int":1099511627776,''' \
+                   '''"list":[1,"two",[3]],"none":null,"str":"Grüße","tuple":[1,2]}
+'''
+
+
+def test_render_dict_raises_on_too_large_int(views_mock):
+    renderer = QuickJsRendererBuilder().source(views_mock).unique()
+    with pytest.raises(OverflowError):
+        renderer.render_tostring("Mock", {"int": 10 ** 400})
+
+
+def test_render_dict_lazy(quickjs_renderer, todolist_parameters, todolist_html):
+    parameters = json.loads(json.dumps(todolist_parameters, cls=Encoder))
+    html = quickjs_renderer.render_tostring(
+        view="TodoList",
+        parameters=parameters,
+        lazy=True
+    )
+    assert html == todolist_html
+
+
+def test_render_dict_lazy_enumerable(views_mock):
+    renderer = QuickJsRendererBuilder().source(views_mock).unique()
+    html = renderer.render_tostring("Mock", {
+        "person": {"name": "John Doe", "tags": [{"id": 1}, {"id": 2}]},
+        "total": 2
+    }, lazy=True)
+    assert html == """
+View: Mock
+Parameters: {"person":{"name":"John Doe","tags":[{"id":1},{"id":2}]},"total":2}
+"""
+
+
+def test_render_dict_lazy_non_string_keys(views_mock):
+    renderer = QuickJsRendererBuilder().source(views_mock).unique()
+    html = renderer.render_tostring("Mock", {"person": {1: "one", "name": "Jo"}}, lazy=True)
+    assert html == """
+View: Mock
+Parameters: {"person":{"1":"one","name":"Jo"}}
+"""
+
+
+def test_render_dict_as_json(quickjs_renderer, todolist_parameters, todolist_html):
+    html = quickjs_renderer.render_tostring(
+        view="TodoList",
+        parameters=todolist_parameters,
+        as_json=True
+    )
+    assert html == todolist_html
+    assert quickjs_renderer.render_tobytes("TodoList", todolist_parameters,
+                                           as_json=True) == todolist_html.encode()
+    stream = StringStream()
+    quickjs_renderer.render("TodoList", todolist_parameters, stream, as_json=True)
+    assert stream.str() == todolist_html
+
+
+def test_render_dict_as_json_rejects_lazy(quickjs_renderer, todolist_parameters):
+    with pytest.raises(ValueError, match="either lazy or as_json"):
+        quickjs_renderer.render_tostring("TodoList", todolist_parameters,
+                                         lazy=True, as_json=True)
+
+
+def test_render_dict_as_json_rejects_functions(quickjs_renderer):
+    with pytest.raises(TypeError):
+        quickjs_renderer.render_tostring("TodoList", {"todos": [], "f": print},
+                                         as_json=True)
+
+
+def test_render_passes_values_to_bindings(todolist_parameters):
+    received = []
+    source = """
+    function render(view, parameters, stream) {
+        stream.write(String(callback({list: [1, "two"], nested: {yes: true}}, parameters.todo, x => x + 1)))
+    }
+    """
+    renderer = QuickJsRendererBuilder() \
+        .source(source) \
+        .bindings({"callback": lambda obj, todo, increment: received.append((obj, todo)) or increment(41)}) \
+        .unique()
+    todo = todolist_parameters["todos"][0]
+    assert renderer.render_tostring("Callback", {"todo": todo}) == "42"
+    assert received == [({"list": [1, "two"], "nested": {"yes": True}}, todo)]
+    assert received[0][1] is todo
+
+
+def test_render_functions_passed_to_python_expire():
+    kept = []
+    source = """
+    function render(view, parameters, stream) {
+        stream.write(String(keep(x => x + 1)))
+    }
+    """
+    renderer = QuickJsRendererBuilder() \
+        .source(source) \
+        .bindings({"keep": lambda increment: kept.append(increment) or increment(1)}) \
+        .unique()
+    assert renderer.render_tostring("Keep", {}) == "2"
+    with pytest.raises(RuntimeError, match="only callable"):
+        kept[0](1)
+
+
+def test_render_dispatches_prototypes():
+    class Counter:
+        __slots__ = ["count"]
+
+        def __init__(self):
+            self.count = 0
+
+        def add(self, amount):
+            self.count += amount
+            return self.count
+
+    source = """
+    function render(view, parameters, stream) {
+        var counter = parameters.counter;
+        counter.count = 10;
+        counter.add(5);
+        stream.write(String(counter.add(1) + counter.count));
+    }
+    """
+    counter = Counter()
+    renderer = QuickJsRendererBuilder().source(source).prototypes([Counter]).unique()
+    assert renderer.render_tostring("Counter", {"counter": counter}) == "32"
+    assert counter.count == 16
+
+
+def test_render_prototypes_respect_instance_attributes():
+    class Greeter:
+        def greet(self, name):
+            return "Hello " + name
+
+    source = """
+    function render(view, parameters, stream) {
+        stream.write(parameters.greeters.map(g => g.greet("John")).join("|"));
+    }
+    """
+    shadowed = Greeter()
+    shadowed.greet = lambda name: "Hi " + name
+    renderer = QuickJsRendererBuilder().source(source).prototypes([Greeter]).unique()
+    greeters = [Greeter(), shadowed]
+    assert renderer.render_tostring("Greeters", {"greeters": greeters}) == "Hello John|Hi John"
@@ -11,7 +11,12 @@
 #  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
 #  See the License for the specific language governing permissions and
 #  limitations under the License.
-from complatecpp import QuickJsRendererBuilder
+import json
+import locale
+import pytest
+from complatecpp import QuickJsRendererBuilder, runtime_hook
+
+from fixtures.teststream import TestStream
 
 
 def test_build_with_values(views, bindings, prototypes, todolist_html, todolist_parameters):
@@ -32,3 +37,372 @@ def test_build_with_creators(views_creator, bindings_creator, prototypes_creator
         .unique()
     html = renderer.render_tostring("TodoList", todolist_parameters)
     assert html == todolist_html
+
+
+def test_build_with_source_file(views_path, bindings, prototypes, todolist_html, todolist_parameters):
+    renderer = QuickJsRendererBuilder() \
+        .source_file(views_path) \
+        .bindings(bindings) \
+        .prototypes(prototypes) \
+        .unique()
+    html = renderer.render_tostring("TodoList", todolist_parameters)
+    assert html == todolist_html
+
+
+def test_build_with_source_file_missing(views_path):
+    builder = QuickJsRendererBuilder().source_file(views_path + ".missing")
+    with pytest.raises(RuntimeError, match="Can.t read views from"):
+        builder.unique()
+
+
+def test_build_many(views_creator, bindings_creator, prototypes, todolist_html, todolist_parameters):
+    calls = []
+
+    def views():
+        calls.append("views")
+        return views_creator()
+
+    renderers = QuickJsRendererBuilder() \
+        .source(views) \
+        .bindings(bindings_creator) \
+        .prototypes(prototypes) \
+        .many(3)
+    assert len(renderers) == 3
+    assert calls == ["views"]
+    for renderer in renderers:
+        assert renderer.render_tostring("TodoList", todolist_parameters) == todolist_html
+
+
+COUNTING_VIEWS = """
+var renders = 0;
+
+function render(view, parameters, stream) {
+    stream.write(String(++renders));
+}
+"""
+
+
+def test_build_recycle_after():
+    renderer = QuickJsRendererBuilder().source(COUNTING_VIEWS).recycle_after(2).unique()
+    assert [renderer.render_tostring("View", {}) for _ in range(5)] == ["1", "2", "1", "2", "1"]
+
+
+def test_build_recycle_after_calls_creators_once():
+    calls = []
+
+    def views():
+        calls.append("views")
+        return COUNTING_VIEWS
+
+    renderer = QuickJsRendererBuilder().source(views).recycle_after(1).unique()
+    assert [renderer.render_tostring("View", {}) for _ in range(3)] == ["1", "1", "1"]
+    assert calls == ["views"]
+
+
+def test_build_pool_recycle_after():
+    pool = QuickJsRendererBuilder().source(COUNTING_VIEWS).recycle_after(2).pool(1)
+    renders = [int(pool.render_tostring("View", {})) for _ in range(8)]
+    assert max(renders) <= 4
+    assert renders.count(1) >= 2
+
+
+GROWING_VIEWS = """
+var kept = [];
+
+function render(view, parameters, stream) {
+    if (view === "Grow") {
+        for (var i = 0; i < 10000; ++i) {
+            kept.push({index: i});
+        }
+    } else if (view === "Recurse") {
+        var recurse = function (depth) { return depth === 0 ? 0 : 1 + recurse(depth - 1); };
+        recurse(parameters.depth);
+    }
+    stream.write(String(kept.length));
+}
+"""
+
+requires_runtime_hook = pytest.mark.skipif(not runtime_hook, reason="requires the runtime hook")
+
+
+@requires_runtime_hook
+def test_build_recycle_after_heap_bytes():
+    renderer = QuickJsRendererBuilder().source(GROWING_VIEWS).recycle_after(0, heap_bytes=1024 * 1024).unique()
+    assert renderer.render_tostring("Grow", {}) == "10000"
+    outputs = [renderer.render_tostring("Grow", {}) for _ in range(20)]
+    assert "10000" in outputs
+
+
+@requires_runtime_hook
+def test_build_pool_recycle_after_heap_bytes():
+    pool = QuickJsRendererBuilder().source(GROWING_VIEWS).recycle_after(0, heap_bytes=1024 * 1024).pool(1)
+    outputs = [int(pool.render_tostring("Grow", {})) for _ in range(40)]
+    assert max(outputs) < 400000
+
+
+@requires_runtime_hook
+def test_build_memory_limit():
+    renderer = QuickJsRendererBuilder().source(GROWING_VIEWS).memory_limit(8 * 1024 * 1024).unique()
+    with pytest.raises(RuntimeError, match=".*out of memory.*"):
+        for _ in range(100):
+            renderer.render_tostring("Grow", {})
+
+
+@requires_runtime_hook
+def test_build_max_stack_size():
+    renderer = QuickJsRendererBuilder().source(GROWING_VIEWS).max_stack_size(128 * 1024).unique()
+    assert renderer.render_tostring("Recurse", {"depth": 10}) == "0"
+    with pytest.raises(RuntimeError, match=".*stack overflow.*"):
+        renderer.render_tostring("Recurse", {"depth": 100000})
+
+
+@requires_runtime_hook
+def test_build_pool_gc_threshold_collect_when_idle():
+    pool = QuickJsRendererBuilder() \
+        .source(GROWING_VIEWS) \
+        .gc_threshold(64 * 1024 * 1024) \
+        .collect_when_idle() \
+        .pool(2)
+    assert [pool.render_tostring("View", {}) for _ in range(4)] == ["0"] * 4
+
+
+@pytest.mark.skipif(runtime_hook, reason="requires a build without the runtime hook")
+def test_build_runtime_options_require_runtime_hook():
+    with pytest.raises(RuntimeError, match=".*runtime hook.*"):
+        QuickJsRendererBuilder().memory_limit(1024 * 1024)
+
+
+@requires_runtime_hook
+def test_build_bytecode_cache(views, bindings, prototypes, todolist_parameters, todolist_html):
+    builder = QuickJsRendererBuilder().source(views).bindings(bindings).prototypes(prototypes).bytecode_cache()
+    for renderer in builder.many(3):
+        assert renderer.render_tostring("TodoList", todolist_parameters) == todolist_html
+    pool = builder.pool(2)
+    assert pool.render_tostring("TodoList", todolist_parameters) == todolist_html
+
+
+@requires_runtime_hook
+def test_build_bytecode_cache_directory(tmp_path):
+    QuickJsRendererBuilder().source(COUNTING_VIEWS).bytecode_cache(str(tmp_path)).unique()
+    files = list(tmp_path.glob("views-*.qjsbc"))
+    assert len(files) == 1
+    bytecode = files[0].read_bytes()
+    renderer = QuickJsRendererBuilder().source(COUNTING_VIEWS).bytecode_cache(str(tmp_path)).unique()
+    assert renderer.render_tostring("View", {}) == "1"
+    assert files[0].read_bytes() == bytecode
+    # Another source gets a file of its own
+    QuickJsRendererBuilder().source(GROWING_VIEWS).bytecode_cache(str(tmp_path)).unique()
+    assert len(list(tmp_path.glob("views-*.qjsbc"))) == 2
+
+
+@requires_runtime_hook
+def test_build_bytecode_cache_compiles_unreadable_file_again(tmp_path):
+    QuickJsRendererBuilder().source(COUNTING_VIEWS).bytecode_cache(str(tmp_path)).unique()
+    file = next(tmp_path.glob("views-*.qjsbc"))
+    file.write_bytes(b"\xff" * 16)
+    renderer = QuickJsRendererBuilder().source(COUNTING_VIEWS).bytecode_cache(str(tmp_path)).unique()
+    assert renderer.render_tostring("View", {}) == "1"
+    assert file.read_bytes() != b"\xff" * 16
+
+
+@requires_runtime_hook
+def test_build_bytecode_cache_raises_syntax_error():
+    with pytest.raises(RuntimeError, match=".*SyntaxError.*"):
+        QuickJsRendererBuilder().source("function render(").bytecode_cache().unique()
+
+
+def test_build_static_views():
+    renderer = QuickJsRendererBuilder().source(COUNTING_VIEWS).static_views(["Head"]).unique()
+    assert [renderer.render_tostring("Head", {}) for _ in range(3)] == ["1", "1", "1"]
+    assert [renderer.render_tostring("Body", "{}") for _ in range(2)] == ["1", "2"]
+
+
+def test_build_static_views_flush_stream():
+    class FlushingStream(TestStream):
+        flushed = ""
+
+        def flush(self):
+            self.flushed = self.data
+
+    renderer = QuickJsRendererBuilder().source(COUNTING_VIEWS).static_views(["Head"]).unique()
+    stream = FlushingStream()
+    renderer.render("Head", {}, stream)
+    assert stream.flushed == "1"
+
+
+def test_build_static_views_spliced_into_other_views():
+    views = """
+    var renders = 0;
+
+    function render(view, parameters, stream) {
+        if (view === "Head") {
+            stream.write("<head>" + String(++renders) + "</head>");
+        } else {
+            stream.write(complatecppStatic.Head + "<body>" + String(++renders) + "</body>");
+        }
+    }
+    """
+    pool = QuickJsRendererBuilder().source(views).static_views(["Head"]).pool(1)
+    assert pool.render_tostring("Page", {}) == "<head>1</head><body>1</body>"
+    assert pool.render_tostring("Page", {}) == "<head>1</head><body>2</body>"
+
+
+def test_build_static_views_with_parameters(views_mock):
+    pool = QuickJsRendererBuilder() \
+        .source(views_mock) \
+        .static_views({"Footer": {"year": 2021}}) \
+        .pool(2)
+    expected = """
+View: Footer
+Parameters: {"year":2021}
+"""
+    assert pool.render_tostring("Footer", {"year": 1999}) == expected
+    assert pool.render_batch([("Footer", {})] * 4) == [expected] * 4
+
+
+HELPERS_VIEWS = """
+function render(view, parameters, stream) {
+    stream.write([
+        complatecpp.escapeHtml(parameters.text),
+        complatecpp.escapeHtml(parameters.text, true),
+        complatecpp.join(["a", 1, 2.5, true], "|"),
+        complatecpp.formatNumber(-1234567.891, 2),
+        complatecpp.formatNumber(1234.6, 0, ".", ",")
+    ].join("\\n"));
+}
+"""
+
+
+def test_build_native_helpers():
+    renderer = QuickJsRendererBuilder().source(HELPERS_VIEWS).native_helpers().pool(1)
+    html = renderer.render_tostring("View", {"text": "<a href=\"x\">Tom & Jerry's</a>"})
+    assert html.split("\n") == [
+        "&lt;a href=\"x\"&gt;Tom &amp; Jerry's&lt;/a&gt;",
+        "&lt;a href=&quot;x&quot;&gt;Tom &amp; Jerry&#x27;s&lt;/a&gt;",
+        "a|1|2.5|true",
+        "-1,234,567.89",
+        "1.235"
+    ]
+
+
+HELPERS_SEMANTICS_VIEWS = """
+function render(view, parameters, stream) {
+    var values = [42, 0.1, 1 / 3, -0, 1e21, 123456789012345680000, 1.5e-7, 5e-324, -2.5e-5, null, undefined, true, [1, [2, 3]]];
+    var lines = [];
+    values.forEach(function (value) {
+        lines.push([complatecpp.escapeHtml(value), String(value)]);
+    });
+    lines.push([complatecpp.join(values, "|"), values.join("|")]);
+    lines.push([complatecpp.join(["a", null, undefined, "b"]), ["a", null, undefined, "b"].join()]);
+    stream.write(JSON.stringify(lines));
+}
+"""
+
+
+def test_build_native_helpers_match_javascript():
+    renderer = QuickJsRendererBuilder().source(HELPERS_SEMANTICS_VIEWS).native_helpers().unique()
+    for native, javascript in json.loads(renderer.render_tostring("View", {})):
+        assert native == javascript
+
+
+@pytest.fixture
+def comma_decimal_point():
+    previous = locale.setlocale(locale.LC_NUMERIC)
+    for name in ["de_DE.UTF-8", "de_DE.utf8", "fr_FR.UTF-8", "fr_FR.utf8"]:
+        try:
+            locale.setlocale(locale.LC_NUMERIC, name)
+            break
+        except locale.Error:
+            pass
+    else:
+        pytest.skip("requires a locale with a comma as decimal point")
+    yield
+    locale.setlocale(locale.LC_NUMERIC, previous)
+
+
+def test_build_native_helpers_ignore_locale(comma_decimal_point):
+    renderer = QuickJsRendererBuilder().source(HELPERS_VIEWS).native_helpers().unique()
+    html = renderer.render_tostring("View", {"text": ""})
+    assert html.split("\n")[2:] == ["a|1|2.5|true", "-1,234,567.89", "1.235"]
+    renderer = QuickJsRendererBuilder().source(HELPERS_SEMANTICS_VIEWS).native_helpers().unique()
+    for native, javascript in json.loads(renderer.render_tostring("View", {})):
+        assert native == javascript
+
+
+def test_build_native_helpers_format_number_throws_on_non_number():
+    source = "function render(view, parameters, stream) { stream.write(complatecpp.formatNumber('1')) }"
+    renderer = QuickJsRendererBuilder().source(source).native_helpers().unique()
+    with pytest.raises(RuntimeError, match="formatNumber.. expects a number"):
+        renderer.render_tostring("View", {})
+
+
+def test_build_native_helpers_disabled_by_default():
+    source = "function render(view, parameters, stream) { stream.write(typeof complatecpp) }"
+    assert QuickJsRendererBuilder().source(source).unique().render_tostring("View", {}) == "undefined"
+
+
+FROZEN_VIEWS = """
+function render(view, parameters, stream) {
+    if (view === "Assign") {
+        i18n.greeting = "Hi";
+    }
+    stream.write([
+        i18n.greeting,
+        i18n.nested.farewell,
+        flags.map(function (flag) { return flag.name; }).join("|"),
+        Object.keys(i18n).join("|"),
+        "missing" in i18n,
+        limit
+    ].join("\\n"));
+}
+"""
+
+FROZEN_BINDINGS = {
+    "i18n": {"greeting": "Hello", "nested": {"farewell": "Bye"}},
+    "flags": [{"name": "a"}, {"name": "b"}],
+    "limit": 3
+}
+
+
+def test_build_frozen_bindings():
+    renderer = QuickJsRendererBuilder().source(FROZEN_VIEWS).frozen_bindings(FROZEN_BINDINGS).unique()
+    assert renderer.render_tostring("View", {}).split("\n") == [
+        "Hello", "Bye", "a|b", "greeting|nested", "false", "3"
+    ]
+
+
+def test_build_frozen_bindings_are_read_only():
+    renderer = QuickJsRendererBuilder().source(FROZEN_VIEWS).frozen_bindings(FROZEN_BINDINGS).unique()
+    with pytest.raises(RuntimeError, match=".*read-only.*"):
+        renderer.render_tostring("Assign", {})
+    assert renderer.render_tostring("View", {}).startswith("Hello\n")
+
+
+def test_build_frozen_bindings_replace_bindings():
+    renderer = QuickJsRendererBuilder() \
+        .source(FROZEN_VIEWS) \
+        .bindings({"limit": 1}) \
+        .frozen_bindings(FROZEN_BINDINGS) \
+        .unique()
+    assert renderer.render_tostring("View", {}).endswith("\n3")
+
+
+def test_build_frozen_bindings_look_up_many_keys():
+    views = """
+    function render(view, parameters, stream) {
+        stream.write([
+            "k999" in table, "k1000" in table, "k1000" in table, table.k500
+        ].join("|"));
+    }
+    """
+    table = {"k%d" % i: i for i in range(1000)}
+    renderer = QuickJsRendererBuilder().source(views).frozen_bindings({"table": table}).unique()
+    assert renderer.render_tostring("View", {}) == "true|false|false|500"
+
+
+def test_build_frozen_bindings_shared_by_pool():
+    bindings = dict(FROZEN_BINDINGS)
+    pool = QuickJsRendererBuilder().source(FROZEN_VIEWS).frozen_bindings(bindings).pool(4)
+    bindings["limit"] = 5
+    for _ in range(8):
+        assert pool.render_tostring("View", {}).endswith("\n3")
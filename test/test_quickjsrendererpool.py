@@ -0,0 +1,343 @@
+# Copyright 2021 Torsten Mehnert
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#      http://www.apache.org/licenses/LICENSE-2.0
+#
+#  Unless required by applicable law or agreed to in writing, software
+#  distributed under the License is distributed on an "AS IS" BASIS,
+#  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+#  See the License for the specific language governing permissions and
+#  limitations under the License.
+import asyncio
+import json
+import os
+import pytest
+import subprocess
+import sys
+import time
+from concurrent.futures import ThreadPoolExecutor
+from complatecpp import QuickJsRendererBuilder, QuickJsRendererPool, StringStream, prepare_fork, \
+    after_fork_in_parent, after_fork_in_child
+
+from fixtures.encoder import Encoder
+from fixtures.teststream import TestStream
+
+
+@pytest.fixture
+def quickjs_renderer_pool(views, bindings, prototypes):
+    return QuickJsRendererBuilder() \
+        .source(views) \
+        .bindings(bindings) \
+        .prototypes(prototypes) \
+        .pool(4)
+
+
+def test_construct_throws_render_undefined():
+    with pytest.raises(RuntimeError, match=".*ReferenceError: 'render' is not defined.*"):
+        QuickJsRendererBuilder().source("").pool(2)
+
+
+def test_construct_throws_on_empty_pool(views):
+    with pytest.raises(ValueError, match=".*at least one renderer.*"):
+        QuickJsRendererPool(QuickJsRendererBuilder().source(views), 0)
+
+
+def test_size(quickjs_renderer_pool):
+    assert quickjs_renderer_pool.size == 4
+
+
+def test_render_dict(quickjs_renderer_pool, todolist_parameters, todolist_html):
+    stream = StringStream()
+    quickjs_renderer_pool.render("TodoList", todolist_parameters, stream)
+    assert stream.str() == todolist_html
+
+
+def test_render_python_stream(views_mock):
+    stream = TestStream()
+    pool = QuickJsRendererBuilder().source(views_mock).pool(2)
+    pool.render("Mock", {"name": "John Doe"}, stream)
+    assert stream.str() == """
+View: Mock
+Parameters: {"name":"John Doe"}
+"""
+
+
+def test_render_throws_view_undefined(quickjs_renderer_pool):
+    with pytest.raises(RuntimeError, match=".*Error: unknown view macro: `MissingView` is not registered.*"):
+        quickjs_renderer_pool.render_tostring("MissingView", {})
+
+
+def test_render_batch_keeps_order(views_mock):
+    pool = QuickJsRendererBuilder().source(views_mock).pool(3)
+    html = pool.render_batch([("View%d" % i, {"i": i}) for i in range(20)])
+    assert html == ["""
+View: View%d
+Parameters: {"i":%d}
+""" % (i, i) for i in range(20)]
+
+
+def test_render_batch_throws_view_undefined(quickjs_renderer_pool, todolist_parameters):
+    with pytest.raises(RuntimeError, match=".*MissingView.*"):
+        quickjs_renderer_pool.render_batch([("TodoList", todolist_parameters), ("MissingView", {})])
+
+
+def test_render_from_many_threads(quickjs_renderer_pool, todolist_parameters, todolist_html):
+    def render(_):
+        return quickjs_renderer_pool.render_tostring("TodoList", todolist_parameters)
+
+    with ThreadPoolExecutor(max_workers=8) as executor:
+        results = list(executor.map(render, range(64)))
+    assert results == [todolist_html] * 64
+
+
+def test_render_iter(quickjs_renderer_pool, todolist_parameters, todolist_html):
+    chunks = list(quickjs_renderer_pool.render_iter("TodoList", todolist_parameters, chunk_size=256))
+    assert len(chunks) > 1
+    assert all(isinstance(chunk, bytes) for chunk in chunks)
+    assert b"".join(chunks) == todolist_html.encode("utf-8")
+
+
+def test_render_iter_throws_view_undefined(quickjs_renderer_pool):
+    with pytest.raises(RuntimeError, match=".*Error: unknown view macro: `MissingView` is not registered.*"):
+        list(quickjs_renderer_pool.render_iter("MissingView", "{}"))
+
+
+def test_render_iter_abandoned(quickjs_renderer_pool, todolist_parameters, todolist_html):
+    for _ in range(quickjs_renderer_pool.size * 2):
+        chunks = quickjs_renderer_pool.render_iter("TodoList", todolist_parameters, chunk_size=16)
+        next(chunks)
+        del chunks
+    assert quickjs_renderer_pool.render_tostring("TodoList", todolist_parameters) == todolist_html
+
+
+def test_render_iter_async(quickjs_renderer_pool, todolist_parameters, todolist_html):
+    async def collect():
+        return [chunk async for chunk in quickjs_renderer_pool.render_iter("TodoList", todolist_parameters)]
+
+    loop = asyncio.new_event_loop()
+    try:
+        chunks = loop.run_until_complete(collect())
+    finally:
+        loop.close()
+    assert b"".join(chunks) == todolist_html.encode("utf-8")
+
+
+def test_render_iter_async_rejects_concurrent_anext(quickjs_renderer_pool, todolist_parameters):
+    async def collect():
+        chunks = quickjs_renderer_pool.render_iter("TodoList", todolist_parameters, chunk_size=16)
+        first = chunks.__anext__()
+        with pytest.raises(RuntimeError, match="another anext"):
+            chunks.__anext__()
+        return [await first] + [chunk async for chunk in chunks]
+
+    assert run(collect())
+
+
+def run(coroutine):
+    loop = asyncio.new_event_loop()
+    try:
+        return loop.run_until_complete(coroutine)
+    finally:
+        loop.close()
+
+
+def test_render_async(quickjs_renderer_pool, todolist_parameters, todolist_html):
+    async def render():
+        return await quickjs_renderer_pool.render_async("TodoList", todolist_parameters)
+
+    assert run(render()) == todolist_html
+
+
+def test_render_async_json_as_bytes(quickjs_renderer_pool, todolist_parameters, todolist_html):
+    async def render():
+        parameters = json.dumps(todolist_parameters, cls=Encoder)
+        return await quickjs_renderer_pool.render_async("TodoList", parameters, as_bytes=True)
+
+    assert run(render()) == todolist_html.encode("utf-8")
+
+
+def test_render_async_gather(quickjs_renderer_pool, todolist_parameters, todolist_html):
+    async def render():
+        return await asyncio.gather(
+            *[quickjs_renderer_pool.render_async("TodoList", todolist_parameters) for _ in range(20)])
+
+    assert run(render()) == [todolist_html] * 20
+
+
+def test_render_async_throws_view_undefined(quickjs_renderer_pool):
+    async def render():
+        return await quickjs_renderer_pool.render_async("MissingView", {})
+
+    with pytest.raises(RuntimeError, match=".*MissingView.*"):
+        run(render())
+
+
+def test_reload(tmp_path):
+    views = tmp_path / "views.js"
+    views.write_text('function render(view, parameters, stream) { stream.write("old") }')
+    pool = QuickJsRendererBuilder().source_file(str(views)).pool(2)
+    assert pool.render_tostring("View", {}) == "old"
+    views.write_text('function render(view, parameters, stream) { stream.write("newer") }')
+    pool.reload()
+    deadline = time.monotonic() + 5
+    while pool.render_tostring("View", {}) != "newer" and time.monotonic() < deadline:
+        time.sleep(0.01)
+    assert [pool.render_tostring("View", {}) for _ in range(4)] == ["newer"] * 4
+
+
+def test_reload_keeps_renderers_on_broken_source(tmp_path):
+    views = tmp_path / "views.js"
+    views.write_text('function render(view, parameters, stream) { stream.write("old") }')
+    pool = QuickJsRendererBuilder().source_file(str(views)).pool(2)
+    views.write_text('function render(view, parameters, stream) {')
+    with pytest.raises(RuntimeError, match=".*SyntaxError.*"):
+        pool.reload()
+    assert pool.render_tostring("View", {}) == "old"
+
+
+def test_failed_replacement_takes_worker_out_of_rotation():
+    broken = []
+    views = """
+    if (isBroken()) {
+        throw new Error("broken views");
+    }
+
+    function render(view, parameters, stream) {
+        stream.write("ok");
+    }
+    """
+    pool = QuickJsRendererBuilder() \
+        .source(views) \
+        .bindings({"isBroken": lambda: bool(broken)}) \
+        .recycle_after(1) \
+        .pool(1)
+    assert pool.render_tostring("View", {}) == "ok"
+    broken.append(True)
+    with pytest.warns(RuntimeWarning, match="broken views"):
+        with pytest.raises(RuntimeError, match="broken views"):
+            deadline = time.monotonic() + 5
+            while time.monotonic() < deadline:
+                pool.render_tostring("View", {})
+    broken.clear()
+    deadline = time.monotonic() + 5
+    while time.monotonic() < deadline:
+        try:
+            if pool.render_tostring("View", {}) == "ok":
+                break
+        except RuntimeError:
+            time.sleep(0.01)
+    assert pool.render_tostring("View", {}) == "ok"
+
+
+def test_watch(tmp_path):
+    views = tmp_path / "views.js"
+    views.write_text('function render(view, parameters, stream) { stream.write("old") }')
+    pool = QuickJsRendererBuilder().source_file(str(views)).pool(1)
+    pool.watch(interval=0.01)
+    try:
+        views.write_text('function render(view, parameters, stream) { stream.write("changed") }')
+        deadline = time.monotonic() + 5
+        while pool.render_tostring("View", {}) != "changed" and time.monotonic() < deadline:
+            time.sleep(0.01)
+        assert pool.render_tostring("View", {}) == "changed"
+    finally:
+        pool.unwatch()
+
+
+def test_watch_warns_about_broken_source(tmp_path):
+    views = tmp_path / "views.js"
+    views.write_text('function render(view, parameters, stream) { stream.write("old") }')
+    pool = QuickJsRendererBuilder().source_file(str(views)).pool(1)
+    with pytest.warns(RuntimeWarning, match=".*couldn't be reloaded.*"):
+        pool.watch(interval=0.01)
+        try:
+            views.write_text('function render(view, parameters, stream) {')
+            time.sleep(0.5)
+        finally:
+            pool.unwatch()
+    assert pool.render_tostring("View", {}) == "old"
+
+
+COUNTING_VIEWS = """
+var renders = 0;
+
+function render(view, parameters, stream) {
+    stream.write(String(++renders));
+}
+"""
+
+
+def test_prepare_fork_pauses_pools():
+    pool = QuickJsRendererBuilder().source(COUNTING_VIEWS).pool(1)
+    assert pool.render_tostring("View", {}) == "1"
+    prepare_fork()
+    try:
+        with ThreadPoolExecutor(1) as executor:
+            paused = executor.submit(pool.render_tostring, "View", {})
+            time.sleep(0.05)
+            assert not paused.done()
+            after_fork_in_parent()
+            assert paused.result(5) == "2"
+    finally:
+        after_fork_in_parent()
+    # The parent keeps its renderers
+    assert pool.render_tostring("View", {}) == "3"
+
+
+@pytest.mark.skipif(not hasattr(os, "fork"), reason="requires os.fork")
+def test_render_in_forked_child(views, bindings, prototypes, todolist_parameters, todolist_html):
+    builder = QuickJsRendererBuilder().source(views).bindings(bindings).prototypes(prototypes)
+    renderer = builder.unique()
+    pool = builder.pool(2)
+    counting = QuickJsRendererBuilder().source(COUNTING_VIEWS).pool(1)
+    assert counting.render_tostring("View", {}) == "1"
+    pool.watch(60)
+    prepare_fork()
+    pid = os.fork()
+    if pid == 0:
+        after_fork_in_child()
+        ok = renderer.render_tostring("TodoList", todolist_parameters) == todolist_html and \
+             pool.render_tostring("TodoList", todolist_parameters) == todolist_html and \
+             counting.render_tostring("View", {}) == "1"
+        os._exit(0 if ok else 1)
+    after_fork_in_parent()
+    _, status = os.waitpid(pid, 0)
+    assert os.WIFEXITED(status) and os.WEXITSTATUS(status) == 0
+    assert pool.render_tostring("TodoList", todolist_parameters) == todolist_html
+    assert counting.render_tostring("View", {}) == "2"
+    pool.unwatch()
+
+
+FORKED_CHILD = """
+import os
+import sys
+import time
+from complatecpp import QuickJsRendererBuilder, register_at_fork
+
+def main():
+    register_at_fork()
+    pool = QuickJsRendererBuilder().source("function render(v, p, s) { s.write('ok'); }").pool(2)
+    pool.render_tostring("View", {})
+    time.sleep(0.1)
+    pid = os.fork()
+    if pid == 0:
+        for _ in range(50):
+            time.sleep(0.01)
+            if pool.render_tostring("View", {}) != "ok":
+                return 1
+        return 0
+    _, status = os.waitpid(pid, 0)
+    return os.WEXITSTATUS(status) if os.WIFEXITED(status) else 1
+
+sys.exit(main())
+"""
+
+
+@pytest.mark.skipif(not hasattr(os, "register_at_fork"), reason="requires os.register_at_fork")
+def test_render_repeatedly_in_forked_child_with_idle_workers():
+    # The child exits normally, which destroys the pool and joins its workers
+    result = subprocess.run([sys.executable, "-c", FORKED_CHILD], timeout=60)
+    assert result.returncode == 0
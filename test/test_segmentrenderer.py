@@ -0,0 +1,114 @@
+# Copyright 2021 Torsten Mehnert
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#      http://www.apache.org/licenses/LICENSE-2.0
+#
+#  Unless required by applicable law or agreed to in writing, software
+#  distributed under the License is distributed on an "AS IS" BASIS,
+#  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+#  See the License for the specific language governing permissions and
+#  limitations under the License.
+import pytest
+from complatecpp import SegmentRenderer, SegmentedPage, QuickJsRendererBuilder, StringStream
+
+
+@pytest.fixture
+def calls():
+    return []
+
+
+@pytest.fixture
+def counting_renderer(calls):
+    source = """
+    function render(view, parameters, stream) {
+        count(view);
+        stream.write("<" + view + ">" + JSON.stringify(parameters) + "</" + view + ">");
+    }
+    """
+    return QuickJsRendererBuilder() \
+        .source(source) \
+        .bindings({"count": lambda view: calls.append(view)}) \
+        .unique()
+
+
+def test_render_segments(counting_renderer, calls):
+    renderer = SegmentRenderer(counting_renderer)
+    stream = StringStream()
+    changed = renderer.render_segments([
+        ("header", "Header", {"user": "Jane"}),
+        ("chart", "Chart", '{"points":[1,2]}')
+    ], stream)
+    assert changed == ["header", "chart"]
+    assert calls == ["Header", "Chart"]
+    assert stream.str() == '<Header>{"user":"Jane"}</Header><Chart>{"points":[1,2]}</Chart>'
+    assert renderer.output() == stream.str()
+
+
+def test_render_segments_rerenders_changed_only(counting_renderer, calls):
+    renderer = SegmentRenderer(counting_renderer)
+    renderer.render_segments([("header", "Header", {"user": "Jane"}), ("chart", "Chart", {"points": [1, 2]})])
+    calls.clear()
+
+    changed = renderer.render_segments([("header", "Header", {"user": "Jane"}), ("chart", "Chart", {"points": [3]})])
+    assert changed == ["chart"]
+    assert calls == ["Chart"]
+    assert renderer.segment("chart") == '<Chart>{"points":[3]}</Chart>'
+    assert renderer.output() == '<Header>{"user":"Jane"}</Header><Chart>{"points":[3]}</Chart>'
+
+
+def test_render_segments_reports_removed(counting_renderer, calls):
+    renderer = SegmentRenderer(counting_renderer)
+    renderer.render_segments([("header", "Header", {}), ("chart", "Chart", {})])
+    assert renderer.render_segments([("chart", "Chart", {})]) == ["header"]
+    assert renderer.segment("header") is None
+    assert renderer.output() == "<Chart>{}</Chart>"
+
+
+def test_render_segments_with_functions_always_renders(counting_renderer, calls):
+    renderer = SegmentRenderer(counting_renderer)
+    parameters = {"callback": lambda: None}
+    renderer.render_segments([("header", "Header", parameters)])
+    assert renderer.render_segments([("header", "Header", parameters)]) == ["header"]
+    assert calls == ["Header", "Header"]
+
+
+def test_render_segments_clear(counting_renderer, calls):
+    renderer = SegmentRenderer(counting_renderer)
+    renderer.render_segments([("header", "Header", {})])
+    renderer.clear()
+    assert renderer.render_segments([("header", "Header", {})]) == ["header"]
+
+
+def test_render_segments_per_page(counting_renderer, calls):
+    renderer = SegmentRenderer(counting_renderer)
+    jane, john = SegmentedPage(), SegmentedPage()
+    renderer.render_segments([("header", "Header", {"user": "Jane"})], page=jane)
+    renderer.render_segments([("header", "Header", {"user": "John"})], page=john)
+    calls.clear()
+
+    assert renderer.render_segments([("header", "Header", {"user": "Jane"})], page=jane) == []
+    assert calls == []
+    assert jane.output() == '<Header>{"user":"Jane"}</Header>'
+    assert john.segment("header") == '<Header>{"user":"John"}</Header>'
+    assert renderer.output() == ""
+
+
+def test_render_segments_compares_whole_parameters(counting_renderer, calls):
+    renderer = SegmentRenderer(counting_renderer)
+    renderer.render_segments([("chart", "Chart", '{"points":"' + "1" * 1000 + 'a"}')])
+    assert renderer.render_segments([("chart", "Chart", '{"points":"' + "1" * 1000 + 'b"}')]) == ["chart"]
+    assert calls == ["Chart", "Chart"]
+
+
+def test_render_segments_rejects_duplicate_names(counting_renderer):
+    renderer = SegmentRenderer(counting_renderer)
+    with pytest.raises(ValueError, match=".*unique.*"):
+        renderer.render_segments([("header", "Header", {}), ("header", "Footer", {})])
+
+
+def test_render_delegates(counting_renderer):
+    renderer = SegmentRenderer(counting_renderer)
+    assert renderer.render_tostring("View", {"a": 1}) == '<View>{"a":1}</View>'
@@ -30,3 +30,9 @@ def test_flush():
     stream = StringStream()
     assert stream.flush is not None
     stream.flush()
+
+
+def test_buffer():
+    stream = StringStream()
+    stream.writeln(string="7 chärs", length=8)
+    assert stream.buffer() == "7 chärs\n".encode("utf-8")
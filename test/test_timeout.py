@@ -0,0 +1,150 @@
+# Copyright 2021 Torsten Mehnert
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#      http://www.apache.org/licenses/LICENSE-2.0
+#
+#  Unless required by applicable law or agreed to in writing, software
+#  distributed under the License is distributed on an "AS IS" BASIS,
+#  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+#  See the License for the specific language governing permissions and
+#  limitations under the License.
+import asyncio
+import pytest
+import time
+from complatecpp import QuickJsRendererBuilder, StringStream, runtime_hook
+
+VIEWS = """
+function render(view, parameters, stream) {
+    if (view === "Writes") {
+        while (true) {
+            stream.write("x");
+        }
+    } else if (view === "Calls") {
+        while (true) {
+            tick();
+        }
+    } else if (view === "Loops") {
+        while (true) {
+        }
+    } else if (view === "Spins") {
+        var end = Date.now() + parameters.ms;
+        while (Date.now() < end) {
+        }
+    }
+    stream.write("done");
+}
+"""
+
+BINDINGS = {"tick": lambda: None}
+
+
+def builder():
+    return QuickJsRendererBuilder().source(VIEWS).bindings(BINDINGS)
+
+
+@pytest.mark.parametrize("view", ["Writes", "Calls"])
+def test_render_timeout_ms(view):
+    renderer = builder().unique()
+    start = time.monotonic()
+    with pytest.raises(TimeoutError):
+        renderer.render_tostring(view, {}, timeout_ms=50)
+    assert time.monotonic() - start < 5
+    assert renderer.render_tostring("Done", {}, timeout_ms=50) == "done"
+
+
+def test_render_timeout_ms_to_stream():
+    renderer = builder().unique()
+    with pytest.raises(TimeoutError):
+        renderer.render("Writes", "{}", StringStream(), timeout_ms=50)
+
+
+def test_render_without_timeout():
+    renderer = builder().unique()
+    assert renderer.render_tostring("Done", {}) == "done"
+    assert renderer.render_tobytes("Done", "{}", timeout_ms=1000) == b"done"
+
+
+def test_builder_timeout_recycles_renderer():
+    renderer = builder().timeout(50).unique()
+    with pytest.raises(TimeoutError):
+        renderer.render_tostring("Calls", {})
+    assert renderer.render_tostring("Done", {}) == "done"
+
+
+def test_builder_timeout_overridden_per_call():
+    renderer = builder().timeout(10000).unique()
+    with pytest.raises(TimeoutError):
+        renderer.render_tostring("Writes", {}, timeout_ms=50)
+
+
+@pytest.mark.parametrize("view", ["Writes", "Calls"])
+def test_pool_timeout_ms(view):
+    pool = builder().pool(2)
+    with pytest.raises(TimeoutError):
+        pool.render_tostring(view, {}, timeout_ms=50)
+    assert pool.render_tostring("Done", {}, timeout_ms=1000) == "done"
+
+
+def test_pool_abandons_renderer_stuck_in_javascript():
+    pool = builder().timeout(50).pool(1)
+    start = time.monotonic()
+    with pytest.raises(TimeoutError):
+        pool.render_tostring("Spins", {"ms": 2000})
+    assert time.monotonic() - start < 1
+    # The stuck renderer has been replaced, so the pool keeps rendering.
+    assert pool.render_tostring("Done", {}) == "done"
+    assert pool.size == 1
+
+
+@pytest.mark.skipif(not runtime_hook, reason="requires the runtime hook")
+def test_render_timeout_ms_interrupts_javascript():
+    renderer = builder().unique()
+    start = time.monotonic()
+    with pytest.raises(TimeoutError):
+        renderer.render_tostring("Loops", {}, timeout_ms=50)
+    assert time.monotonic() - start < 5
+    assert renderer.render_tostring("Done", {}) == "done"
+
+
+def test_pool_timeout_applies_to_render_async():
+    pool = builder().timeout(50).pool(1)
+
+    async def render():
+        return await pool.render_async("Calls", {})
+
+    loop = asyncio.new_event_loop()
+    try:
+        with pytest.raises(TimeoutError):
+            loop.run_until_complete(render())
+    finally:
+        loop.close()
+    assert pool.render_tostring("Done", {}) == "done"
+
+
+def test_pool_timeout_applies_to_render_iter():
+    pool = builder().timeout(50).pool(1)
+    with pytest.raises(TimeoutError):
+        for _ in pool.render_iter("Writes", {}):
+            pass
+    assert pool.render_tostring("Done", {}) == "done"
+
+
+def test_pool_timeout_applies_to_render_batch():
+    pool = builder().timeout(50).pool(2)
+    with pytest.raises(TimeoutError):
+        pool.render_batch([("Done", {}), ("Calls", {})])
+    assert pool.render_batch([("Done", {})] * 2) == ["done"] * 2
+
+
+def test_pool_joins_abandoned_renderers_on_shutdown():
+    pool = builder().timeout(50).pool(1)
+    for _ in range(3):
+        with pytest.raises(TimeoutError):
+            pool.render_tostring("Spins", {"ms": 300})
+    start = time.monotonic()
+    del pool
+    # Waits for the views still spinning, at most one per renderer of the pool
+    assert time.monotonic() - start < 5